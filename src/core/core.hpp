@@ -3,6 +3,7 @@
 
 #include "components.hpp"
 #include "gameobject.hpp"
+#include "pathservice.hpp"
 #include "systems.hpp"
 
 #endif
\ No newline at end of file
@@ -7,6 +7,9 @@ namespace core {
 GameObject::GameObject(std::mt19937 &rng, int width, int height)
     : rng(rng), map(MapData(rng, height, width)),
       ticks(TickController(1000 / FRAMERATE)), rhs(Log(100)) {
+  // Positions and paths are iterated together by the pathfinder.
+  world.group<PositionComponent, PathComponent>();
+
   // Creates the map and place the player.
   player = world.createEntity();
   last_position = map.getRandomSpawn();
@@ -22,6 +25,11 @@ void GameObject::registerSystem(
   world.addSystem(system);
 }
 
+void GameObject::registerSystem(
+    std::function<void(ecs::World &, MapData &)> system, ecs::Access access) {
+  world.addSystem(system, std::move(access));
+}
+
 void GameObject::start() {
   PositionComponent *pos = world.getComponent<PositionComponent>(player);
   view.draw(map, *pos, rhs.getText(), bhs);
@@ -29,6 +37,7 @@ void GameObject::start() {
 
   while (true) {
     // Process all of the systems.
+    ecs::Tick since = world.tick();
     world.update(this->map);
     pos = world.getComponent<PositionComponent>(player);
 
@@ -47,11 +56,12 @@ void GameObject::start() {
         rhs.add(color::Foreground::RED, color::Style::BOLD, "location blocked");
       } else {
         *pos = temp;
+        world.markChanged<PositionComponent>(player);
       }
     }
 
     // Update the RHS log.
-    if (last_position != *pos) {
+    if (world.isChanged<PositionComponent>(player, since)) {
       if (pos->x > last_position.x) {
         rhs.add("moved east");
       } else if (pos->x < last_position.y) {
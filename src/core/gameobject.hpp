@@ -7,6 +7,7 @@
 #include "../tick.hpp"
 #include "../ui/camera.hpp"
 #include "../util/log.hpp"
+#include "pathservice.hpp"
 #include <random>
 
 namespace core {
@@ -23,13 +24,16 @@ private:
   std::mt19937 rng;
 
 public:
-  ecs::World world; // ECS / World controller.
-  MapData map;      // Map data.
+  ecs::World world;  // ECS / World controller.
+  MapData map;       // Map data.
+  PathService paths; // Path requests solved off the tick.
 
   GameObject(std::mt19937 &rng, int width, int height);
 
   // Registers a new system within the ECS.
   void registerSystem(std::function<void(ecs::World &, MapData &)> system);
+  void registerSystem(std::function<void(ecs::World &, MapData &)> system,
+                      ecs::Access access);
   void start(); // Starts the game loop.
 };
 
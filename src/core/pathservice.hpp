@@ -0,0 +1,247 @@
+#ifndef _CORE_PATH_SERVICE_HPP
+#define _CORE_PATH_SERVICE_HPP
+
+#include "../ecs/ecs.hpp"
+#include "../map/map.hpp"
+#include "../pathfind/pathfind.hpp"
+#include "../util/threadpool.hpp"
+#include "components.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace core {
+
+// Solves path requests on worker threads so the tick never waits on a
+// search. Every tick the workers share a budget of expanded cells, a search
+// that runs out is resumed on the next tick. Searches go through the map's
+// router, the results are written into PathComponent once the workers
+// finish on a later tick.
+class PathService {
+public:
+  explicit PathService(std::size_t budget = 65536,
+                       std::size_t threads = defaultThreads())
+      : budget(budget), pool(threads) {
+    workers.resize(pool.size());
+  }
+
+  // Waits for the workers, they refer to the service.
+  ~PathService() { pool.wait(); }
+
+  PathService(const PathService &) = delete;
+  PathService &operator=(const PathService &) = delete;
+
+  // Maximum amount of cells expanded per tick over every worker.
+  std::size_t getBudget() const { return budget; }
+  void setBudget(std::size_t amount) {
+    budget = std::max<std::size_t>(amount, 1);
+  }
+
+  // Amount of requests waiting to be started, as of the latest update.
+  std::size_t getQueued() const { return queued.size() + waiting; }
+
+  // Requests a path for the entity, replacing any request it has pending.
+  void request(ecs::Entity entity, const Vec2i &src, const Vec2i &dest) {
+    std::uint64_t ticket = ++tickets;
+    pending[entity] = ticket;
+    queued.push_back({entity, src, dest, ticket});
+  }
+
+  // Checks if the entity is still waiting on a path.
+  bool isPending(ecs::Entity entity) const {
+    return pending.find(entity) != pending.end();
+  }
+
+  // Stops waiting on a path for the entity, its result will be dropped.
+  void cancel(ecs::Entity entity) { pending.erase(entity); }
+
+  // Delivers the paths found since the last call and gives the workers the
+  // next budget. Called once per tick, never blocks on the workers.
+  void update(ecs::World &world, MapData &map) {
+    if (remaining.load(std::memory_order_acquire) > 0) {
+      return;
+    }
+
+    deliver(world);
+    launch(map);
+  }
+
+private:
+  // Path requested for an entity.
+  struct Request {
+    ecs::Entity entity;
+    Vec2i src, dest;
+    std::uint64_t ticket; // Identifies the latest request of the entity.
+  };
+
+  // Path found for a request.
+  struct Result {
+    ecs::Entity entity;
+    std::uint64_t ticket;
+    std::vector<Vec2i> path;
+  };
+
+  // Requests handed to a worker and the state of its search.
+  struct Worker {
+    MapRouter::Workspace workspace;
+    std::optional<Request> active; // Request being searched.
+    std::deque<Request> assigned;  // Requests not started yet.
+    std::vector<Result> results;   // Finished since the last delivery.
+  };
+
+  std::size_t budget;          // Cells expanded per tick.
+  std::deque<Request> queued;  // Requests not handed to a worker yet.
+  std::size_t waiting = 0;     // Handed out but not started, at launch.
+  std::unordered_map<ecs::Entity, std::uint64_t> pending; // Latest tickets.
+  std::uint64_t tickets = 0;   // Last ticket handed out.
+
+  MapRouter *router = nullptr;            // Router of the latest map.
+  std::vector<Worker> workers;            // State per worker.
+  std::atomic<std::size_t> remaining = 0; // Workers still solving.
+  ThreadPool pool;
+
+  static std::size_t defaultThreads() {
+    std::size_t threads = std::thread::hardware_concurrency();
+    return threads > 1 ? threads - 1 : 1;
+  }
+
+  // Checks if the request is still the latest one of its entity.
+  bool isCurrent(const Request &request) const {
+    auto found = pending.find(request.entity);
+    return found != pending.end() && found->second == request.ticket;
+  }
+
+  // Writes the finished paths into the entities that are still waiting.
+  void deliver(ecs::World &world) {
+    for (Worker &worker : workers) {
+      for (Result &result : worker.results) {
+        auto found = pending.find(result.entity);
+        if (found == pending.end() || found->second != result.ticket) {
+          continue; // Cancelled or requested again since.
+        }
+
+        pending.erase(found);
+        if (!world.isAlive(result.entity)) {
+          continue;
+        }
+
+        PathComponent *path = world.getComponent<PathComponent>(result.entity);
+        if (path == nullptr) {
+          continue;
+        }
+
+        path->path = std::queue<Vec2i>();
+        for (const Vec2i &step : result.path) {
+          path->path.push(step);
+        }
+
+        world.markChanged<PathComponent>(result.entity);
+      }
+
+      worker.results.clear();
+    }
+  }
+
+  // Hands the queued requests to the workers and starts them on the budget.
+  void launch(MapData &map) {
+    if (router != &map.getRouter()) {
+      // Searches in progress belong to another map.
+      router = &map.getRouter();
+      for (Worker &worker : workers) {
+        worker = Worker();
+      }
+    }
+
+    // Drop requests that were cancelled or replaced since they were handed
+    // out, the workers are idle so their state can be changed.
+    for (Worker &worker : workers) {
+      if (worker.active && !isCurrent(*worker.active)) {
+        worker.active.reset();
+      }
+
+      std::erase_if(worker.assigned, [this](const Request &request) {
+        return !isCurrent(request);
+      });
+    }
+
+    // Spread the new requests over the workers, skipping those that cannot
+    // be reached. Searching them would exhaust the start's region.
+    while (!queued.empty()) {
+      Request request = queued.front();
+      queued.pop_front();
+
+      if (!isCurrent(request)) {
+        continue; // Cancelled or requested again since.
+      } else if (!map.isConnected(request.src, request.dest)) {
+        pending.erase(request.entity);
+        continue;
+      }
+
+      // Give it to the worker with the least left to solve.
+      auto least = std::min_element(
+          workers.begin(), workers.end(), [](const Worker &a, const Worker &b) {
+            return a.assigned.size() < b.assigned.size();
+          });
+      least->assigned.push_back(request);
+    }
+
+    bool busy = false;
+    waiting = 0;
+    for (const Worker &worker : workers) {
+      busy = busy || worker.active || !worker.assigned.empty();
+      waiting += worker.assigned.size();
+    }
+
+    if (!busy) {
+      return;
+    }
+
+    std::size_t share = std::max<std::size_t>(budget / workers.size(), 1);
+    remaining.store(workers.size(), std::memory_order_release);
+    for (std::size_t i = 0; i < workers.size(); i++) {
+      pool.submit([this, i, share] { solve(workers[i], share); });
+    }
+  }
+
+  // Advances the searches of a worker until its share of the budget is
+  // spent, finishing the one left in progress on the previous tick first.
+  void solve(Worker &worker, std::size_t share) {
+    MapRouter::Workspace &work = worker.workspace;
+    while (share > 0 && (worker.active || !worker.assigned.empty())) {
+      if (!worker.active) {
+        worker.active = worker.assigned.front();
+        worker.assigned.pop_front();
+        router->begin(work, worker.active->src, worker.active->dest);
+      }
+
+      std::size_t before = work.getExpanded();
+      pathfind::SearchStatus status = router->resume(work, share);
+      share -= std::min(share, work.getExpanded() - before);
+      if (status == pathfind::SearchStatus::InProgress) {
+        continue;
+      }
+
+      std::vector<Vec2i> path;
+      if (status == pathfind::SearchStatus::Found) {
+        path = work.getPath();
+      }
+
+      worker.results.push_back(
+          {worker.active->entity, worker.active->ticket, std::move(path)});
+      worker.active.reset();
+    }
+
+    remaining.fetch_sub(1, std::memory_order_acq_rel);
+  }
+};
+
+} // namespace core
+
+#endif
\ No newline at end of file
@@ -4,24 +4,37 @@
 #include "../ecs/ecs.hpp"
 #include "../map/map.hpp"
 #include "components.hpp"
+#include "pathservice.hpp"
+#include <functional>
 
 namespace core {
 
-// Selects a random path for all entities that are currently pathfinding.
-void pathfinder(ecs::World &world, MapData &map) {
-  auto entities = world.getComponents<PositionComponent, PathComponent>();
-  for (auto &entity : entities) {
-    auto [e, pos, pathing] = entity;
-    if (auto next = pathing->next(); next) {
-      // There is a next position to move to.
-      *pos = *next;
-    } else {
-      // Generate a new position to move to.
-      static std::uniform_int_distribution<int> dist(-50, 50);
-      Vec2i target = Vec2i(dist(map.rng), dist(map.rng)) + *pos;
-      pathing->path = map.pathfind(*pos, target);
+// Creates the system that moves entities along their paths, requesting a
+// new random path from the service once a path runs out.
+inline std::function<void(ecs::World &, MapData &)>
+pathfinder(PathService &paths) {
+  return [&paths](ecs::World &world, MapData &map) {
+    paths.update(world, map);
+
+    for (auto [e, pos, pathing] :
+         world.group<PositionComponent, PathComponent>()) {
+      if (auto next = pathing->next(); next) {
+        // There is a next position to move to.
+        *pos = *next;
+        world.markChanged<PositionComponent>(e);
+      } else if (!paths.isPending(e)) {
+        // Request a new position to move to.
+        static std::uniform_int_distribution<int> dist(-50, 50);
+        Vec2i target = Vec2i(dist(map.rng), dist(map.rng)) + *pos;
+        paths.request(e, *pos, target);
+      }
     }
-  }
+  };
+}
+
+// Data accessed by the pathfinder system, used for scheduling.
+inline ecs::Access pathfinderAccess() {
+  return ecs::Access().write<PositionComponent, PathComponent>().writeMap();
 }
 
 } // namespace core
@@ -0,0 +1,98 @@
+#ifndef _ECS_CHANGES_HPP
+#define _ECS_CHANGES_HPP
+
+#include "sparse.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+namespace ecs {
+
+// Non-owning query over the entities whose component T was added or changed
+// after a tick. Only the stamps recorded since then are visited, so the cost
+// scales with the amount of changes rather than the size of the pool.
+template <typename T> class Changes {
+public:
+  using value_type = std::tuple<Entity, T *>;
+
+  // Selects which stamps of the pool are visited.
+  enum class Kind { Added, Changed };
+
+  class Iterator {
+  public:
+    Iterator(const Changes *changes, std::size_t index)
+        : changes(changes), index(index) {
+      skip();
+    }
+
+    value_type operator*() const {
+      Entity entity = (*changes->log)[index].entity;
+      return value_type(entity, changes->set->get(entity));
+    }
+
+    Iterator &operator++() {
+      index++;
+      skip();
+      return *this;
+    }
+
+    friend bool operator==(const Iterator &a, const Iterator &b) {
+      return a.index == b.index;
+    }
+
+    friend bool operator!=(const Iterator &a, const Iterator &b) {
+      return !(a == b);
+    }
+
+  private:
+    const Changes *changes;
+    std::size_t index;
+
+    // Advances past stamps of removed components and superseded stamps, the
+    // latter keeps entities changed multiple times from being visited twice.
+    void skip() {
+      while (index < changes->log->size() &&
+             !changes->isCurrent(index)) {
+        index++;
+      }
+    }
+  };
+
+  Changes(SparseSet<T> &set, Kind kind, Tick since)
+      : set(&set), kind(kind),
+        log(kind == Kind::Added ? &set.addedLog() : &set.changedLog()) {
+    first = std::partition_point(log->begin(), log->end(),
+                                 [since](const Stamp &stamp) {
+                                   return stamp.tick <= since;
+                                 }) -
+            log->begin();
+  }
+
+  Iterator begin() const { return Iterator(this, first); }
+  Iterator end() const { return Iterator(this, log->size()); }
+
+  // Invokes func(entity, T*) for every added or changed component.
+  template <typename Func> void each(Func &&func) const {
+    for (auto &&row : *this) {
+      std::apply(func, row);
+    }
+  }
+
+private:
+  SparseSet<T> *set;
+  Kind kind;
+  const std::vector<Stamp> *log; // Stamps being iterated.
+  std::size_t first;             // First stamp after the tick.
+
+  // Checks if the stamp at the position is the latest for a component that
+  // still exists.
+  bool isCurrent(std::size_t position) const {
+    return kind == Kind::Added ? set->isLatestAdded(position)
+                               : set->isLatestChanged(position);
+  }
+};
+
+} // namespace ecs
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef _ECS_COMMANDS_HPP
+#define _ECS_COMMANDS_HPP
+
+#include "entity.hpp"
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+
+class World;
+
+// Records structural changes (entity creation / destruction, adding and
+// removing components) so they can be applied later at a sync point. Changes
+// made while iterating would otherwise invalidate component pointers.
+class CommandBuffer {
+public:
+  // Reserves a placeholder for an entity created once the buffer is applied.
+  // The placeholder is only meaningful to commands of this buffer.
+  Entity createEntity() { return {pending++, PLACEHOLDER}; }
+
+  // Destroys an entity and all of its components. Defined in world.hpp.
+  void destroyEntity(Entity entity);
+
+  // Adds a component to an entity, the component is constructed immediately.
+  // Skipped if the entity was destroyed before the command is applied.
+  template <typename T, typename... Args>
+  void addComponent(Entity entity, Args &&...args) {
+    commands.push_back([entity, component = T(std::forward<Args>(args)...)](
+                           auto &world, const Created &created) {
+      Entity resolved = resolve(entity, created);
+      if (world.isAlive(resolved)) {
+        world.template addComponent<T>(resolved, component);
+      }
+    });
+  }
+
+  // Removes a component from an entity. Skipped if the entity was destroyed
+  // before the command is applied.
+  template <typename T> void removeComponent(Entity entity) {
+    commands.push_back([entity](auto &world, const Created &created) {
+      Entity resolved = resolve(entity, created);
+      if (world.isAlive(resolved)) {
+        world.template removeComponent<T>(resolved);
+      }
+    });
+  }
+
+  // Checks if there is nothing to apply.
+  bool empty() const { return pending == 0 && commands.empty(); }
+
+  // Discards all recorded commands.
+  void clear() {
+    commands.clear();
+    pending = 0;
+  }
+
+private:
+  friend class World;
+  using Created = std::vector<Entity>; // Entities created for placeholders.
+
+  // Generation reserved to mark placeholder entities.
+  static constexpr std::uint32_t PLACEHOLDER = UINT32_MAX;
+
+  std::vector<std::function<void(World &, const Created &)>> commands;
+  std::uint32_t pending = 0; // Amount of placeholder entities.
+
+  // Swaps placeholders for the entities created when applying.
+  static Entity resolve(Entity entity, const Created &created) {
+    if (entity.generation == PLACEHOLDER) {
+      return created[entity.index];
+    }
+
+    return entity;
+  }
+};
+
+} // namespace ecs
+
+#endif
@@ -1,13 +1,36 @@
 #ifndef _ECS_COMPONENT_HPP
 #define _ECS_COMPONENT_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
 namespace ecs {
 
-// Base Component class for type identification.
-struct Component {
-  virtual ~Component() = default;
-};
+// Base Component class for type identification. Components are stored by
+// value and never deleted through the base, so it carries no vtable. Plain
+// trivially copyable structures may be used as components as well.
+struct Component {};
+
+// Dense identifier assigned to each component type, used to index pools.
+using ComponentId = std::size_t;
+
+namespace internal {
+inline std::atomic<ComponentId> next_component_id = 0;
+} // namespace internal
+
+// Obtains the identifier for a component type. Identifiers are assigned once
+// per type and are shared by every World in the process.
+template <typename T> ComponentId componentId() {
+  using Type = std::remove_cvref_t<T>;
+  if constexpr (!std::is_same_v<T, Type>) {
+    return componentId<Type>();
+  } else {
+    static const ComponentId id = internal::next_component_id++;
+    return id;
+  }
+}
 
 } // namespace ecs
 
-#endif
\ No newline at end of file
+#endif
@@ -2,8 +2,15 @@
 #define _ECS_HPP
 
 #include "../pathfind/pathfind.hpp"
+#include "changes.hpp"
+#include "commands.hpp"
 #include "component.hpp"
+#include "entity.hpp"
+#include "group.hpp"
 #include "sparse.hpp"
+#include "storage.hpp"
+#include "system.hpp"
+#include "view.hpp"
 #include "world.hpp"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef _ECS_ENTITY_HPP
+#define _ECS_ENTITY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace ecs {
+
+// Handle to an entity. Indices are recycled once an entity is destroyed, the
+// generation tells the new owner of an index apart from stale handles.
+struct Entity {
+  static constexpr std::uint32_t INVALID_INDEX = UINT32_MAX;
+
+  std::uint32_t index = INVALID_INDEX; // Slot within the World and pools.
+  std::uint32_t generation = 0;        // Times the slot has been recycled.
+
+  friend bool operator==(const Entity &a, const Entity &b) {
+    return a.index == b.index && a.generation == b.generation;
+  }
+
+  friend bool operator!=(const Entity &a, const Entity &b) { return !(a == b); }
+};
+
+const Entity INVALID_ENTITY = Entity();
+
+} // namespace ecs
+
+namespace std {
+template <> struct hash<ecs::Entity> {
+  std::size_t operator()(const ecs::Entity &e) const {
+    return std::hash<std::uint64_t>()(
+        (static_cast<std::uint64_t>(e.generation) << 32) | e.index);
+  }
+};
+} // namespace std
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef _ECS_GROUP_HPP
+#define _ECS_GROUP_HPP
+
+#include "sparse.hpp"
+#include <cstddef>
+#include <tuple>
+
+namespace ecs {
+
+// Non-owning query over an owning group. The World keeps entities that have
+// every component Ts packed at the front of each pool in the same order, so
+// iterating is a linear walk over parallel arrays.
+template <typename... Ts> class Group {
+  static_assert(sizeof...(Ts) > 1, "Group requires at least two components");
+  static_assert((!SparseSet<Ts>::IS_COLUMNAR && ...),
+                "Group requires components stored as whole structures");
+
+public:
+  using value_type = std::tuple<Entity, Ts *...>;
+
+  class Iterator {
+  public:
+    Iterator(const Group *group, std::size_t index)
+        : group(group), index(index) {}
+
+    value_type operator*() const {
+      return std::apply(
+          [this](auto *...sets) {
+            return value_type(group->lead->entities()[index],
+                              (sets->data() + index)...);
+          },
+          group->sets);
+    }
+
+    Iterator &operator++() {
+      index++;
+      return *this;
+    }
+
+    friend bool operator==(const Iterator &a, const Iterator &b) {
+      return a.index == b.index;
+    }
+
+    friend bool operator!=(const Iterator &a, const Iterator &b) {
+      return !(a == b);
+    }
+
+  private:
+    const Group *group;
+    std::size_t index;
+  };
+
+  Group(const std::size_t &length, SparseSet<Ts> &...sets)
+      : length(&length), sets(&sets...), lead(std::get<0>(this->sets)) {}
+
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, *length); }
+
+  // Amount of entities in the group.
+  std::size_t size() const { return *length; }
+
+  // Invokes func(entity, Ts*...) for every entity in the group.
+  template <typename Func> void each(Func &&func) const {
+    const Entity *entities = lead->entities().data();
+    std::tuple<Ts *...> data(std::get<SparseSet<Ts> *>(sets)->data()...);
+    for (std::size_t i = 0; i < *length; i++) {
+      func(entities[i], (std::get<Ts *>(data) + i)...);
+    }
+  }
+
+private:
+  const std::size_t *length; // Owned by the World, grows and shrinks live.
+  std::tuple<SparseSet<Ts> *...> sets;
+  SparseSet<std::tuple_element_t<0, std::tuple<Ts...>>> *lead;
+};
+
+} // namespace ecs
+
+#endif
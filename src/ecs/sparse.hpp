@@ -2,74 +2,374 @@
 #define _ECS_SPARSE_SET_HPP
 
 #include "component.hpp"
+#include "entity.hpp"
+#include "storage.hpp"
+#include <algorithm>
+#include <array>
 #include <cassert>
-#include <typeindex>
-#include <unordered_map>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
 #include <vector>
 
 namespace ecs {
 
-// An ID to represent an entity.
-using Entity = std::size_t;
-const Entity INVALID_ENTITY = -1;
+// Marks an entity index that has no component in the set.
+const std::size_t INVALID_INDEX = -1;
+
+// World clock used to stamp when components are added or changed.
+using Tick = std::uint64_t;
+
+// Records an entity that had a component added or changed at a tick.
+struct Stamp {
+  Entity entity;
+  Tick tick;
+};
+
+// Maps entity indices to dense positions. The index space is split into fixed
+// size pages that are allocated on demand and released once empty, so memory
+// follows the entities stored rather than the highest entity index.
+class SparseIndex {
+public:
+  static constexpr std::size_t PAGE_SIZE = 1024; // Entity indices per page.
+
+  // Obtains the dense position for an entity index, or INVALID_INDEX.
+  std::size_t find(std::uint32_t index) const {
+    std::size_t page = index / PAGE_SIZE;
+    if (page >= pages.size() || !pages[page]) {
+      return INVALID_INDEX;
+    }
+
+    std::uint32_t slot = pages[page]->slots[index % PAGE_SIZE];
+    return slot == EMPTY ? INVALID_INDEX : slot;
+  }
+
+  // Assigns the dense position for an entity index, allocating its page.
+  void set(std::uint32_t index, std::size_t position) {
+    std::size_t page = index / PAGE_SIZE;
+    if (page >= pages.size()) {
+      pages.resize(page + 1);
+    }
+
+    if (!pages[page]) {
+      pages[page] = std::make_unique<Page>();
+    }
+
+    std::uint32_t &slot = pages[page]->slots[index % PAGE_SIZE];
+    if (slot == EMPTY) {
+      pages[page]->used++;
+    }
+
+    slot = static_cast<std::uint32_t>(position);
+  }
+
+  // Clears an entity index, releasing its page once no index uses it.
+  void release(std::uint32_t index) {
+    std::size_t page = index / PAGE_SIZE;
+    if (page >= pages.size() || !pages[page]) {
+      return;
+    }
+
+    std::uint32_t &slot = pages[page]->slots[index % PAGE_SIZE];
+    if (slot == EMPTY) {
+      return;
+    }
+
+    slot = EMPTY;
+    if (--pages[page]->used == 0) {
+      pages[page].reset();
+    }
+  }
+
+  // Amount of pages currently allocated.
+  std::size_t pageCount() const {
+    std::size_t count = 0;
+    for (const auto &page : pages) {
+      count += page != nullptr;
+    }
+
+    return count;
+  }
 
-// Sparse set for efficient component storage.
-template <typename T> class SparseSet {
 private:
-  std::vector<std::size_t> sparse; // Maps entity IDs to dense indices.
-  std::vector<Entity> dense;       // Stores entity IDs.
-  std::vector<T> components;       // Stores components.
+  static constexpr std::uint32_t EMPTY = UINT32_MAX;
+
+  struct Page {
+    std::array<std::uint32_t, PAGE_SIZE> slots;
+    std::size_t used = 0; // Slots that hold a dense position.
+
+    Page() { slots.fill(EMPTY); }
+  };
+
+  std::vector<std::unique_ptr<Page>> pages;
+};
+
+// Type-erased interface shared by every component pool.
+class BaseSet {
+public:
+  virtual ~BaseSet() = default;
+  virtual void remove(Entity entity) = 0;         // Removes the component.
+  virtual bool contains(Entity entity) const = 0; // Checks for a component.
+  virtual std::size_t size() const = 0;           // Amount of components.
+
+  // Discards change records at or before the tick.
+  virtual void trim(Tick tick) = 0;
+
+  // Entities owning a component, packed in the same order as the components.
+  virtual const std::vector<Entity> &entities() const = 0;
+
+  // Dense position of an entity's component, or INVALID_INDEX.
+  virtual std::size_t indexOf(Entity entity) const = 0;
+
+  // Exchanges two dense positions, used to keep grouped pools aligned.
+  virtual void swapSlots(std::size_t a, std::size_t b) = 0;
+};
+
+// Sparse set for efficient component storage. Components are stored as
+// whole structures unless the type opts into soa_layout.
+template <typename T> class SparseSet : public BaseSet {
+private:
+  using Storage = typename storage_for<T>::type;
+
+  SparseIndex sparse;        // Maps entity indices to dense indices.
+  std::vector<Entity> dense; // Stores entity handles.
+  Storage components;        // Stores components.
+
+  std::vector<Tick> added_ticks, changed_ticks; // Latest stamps, per component.
+  std::vector<Stamp> added_log, changed_log;    // Stamps in order of ticks.
+
+  // Position of the latest stamp of every component in its log, counted
+  // from the first stamp ever logged. A component removed and added again
+  // within a tick leaves two stamps with the same tick, only this one is
+  // current.
+  std::vector<std::uint64_t> added_at, changed_at;
+  std::uint64_t added_trimmed = 0, changed_trimmed = 0; // Stamps discarded.
 
 public:
   SparseSet() {
-    static_assert(std::is_base_of<Component, T>::value,
-                  "T must be a Component");
+    static_assert(std::is_base_of<Component, T>::value ||
+                      std::is_trivially_copyable<T>::value,
+                  "T must be a Component or trivially copyable");
   }
 
-  // Add a new component to an entity.
-  void add(Entity entity, const T &component) {
-    if (entity >= sparse.size()) {
-      sparse.resize(entity + 1, INVALID_ENTITY);
-    }
+  // Checks if components are split into one array per field.
+  static constexpr bool IS_COLUMNAR = SoALayout<T>;
 
+  // Add a new component to an entity, stamping it as added at the tick.
+  // Replacing an existing component stamps it as changed instead.
+  void add(Entity entity, const T &component, Tick tick = 0) {
     // Add the component if it does not exist already.
-    if (sparse[entity] == INVALID_ENTITY) {
-      sparse[entity] = dense.size();
+    std::size_t slot = sparse.find(entity.index);
+    if (slot == INVALID_INDEX) {
+      sparse.set(entity.index, dense.size());
       dense.push_back(entity);
-      components.push_back(component);
+      components.push(component);
+      added_ticks.push_back(tick);
+      changed_ticks.push_back(tick);
+      added_at.push_back(added_trimmed + added_log.size());
+      changed_at.push_back(changed_trimmed + changed_log.size());
+      added_log.push_back({entity, tick});
+      changed_log.push_back({entity, tick});
     } else {
-      components[sparse[entity]] = component;
+      // Slots are released on removal, only the same handle can own it.
+      assert(dense[slot] == entity);
+      components.assign(slot, component);
+      markChanged(entity, tick);
+    }
+  }
+
+  // Adds components to many entities, reserving space for all of them first.
+  void add(std::span<const Entity> entities, std::span<const T> batch,
+           Tick tick = 0) {
+    assert(entities.size() == batch.size());
+    reserve(dense.size() + entities.size());
+    for (std::size_t i = 0; i < entities.size(); i++) {
+      add(entities[i], batch[i], tick);
+    }
+  }
+
+  // Reserves space for a total amount of components.
+  void reserve(std::size_t n) {
+    std::size_t growth = n - std::min(n, dense.size());
+    reserveAtLeast(added_log, added_log.size() + growth);
+    reserveAtLeast(changed_log, changed_log.size() + growth);
+
+    reserveAtLeast(dense, n);
+    components.reserve(n);
+    reserveAtLeast(added_ticks, n);
+    reserveAtLeast(changed_ticks, n);
+    reserveAtLeast(added_at, n);
+    reserveAtLeast(changed_at, n);
+  }
+
+  // Stamps the component of an entity as changed at the tick.
+  void markChanged(Entity entity, Tick tick) {
+    std::size_t slot = sparse.find(entity.index);
+    if (slot == INVALID_INDEX || dense[slot] != entity ||
+        changed_ticks[slot] == tick) {
+      return;
     }
+
+    changed_ticks[slot] = tick;
+    changed_at[slot] = changed_trimmed + changed_log.size();
+    changed_log.push_back({entity, tick});
   }
 
   // Removes an entity and its components from the Sparse Set.
-  void remove(Entity entity) {
-    if (entity >= sparse.size() || sparse[entity] == INVALID_ENTITY) {
+  void remove(Entity entity) override {
+    if (!contains(entity)) {
       return;
     }
 
     Entity lastEntity = dense.back();
-    std::size_t indexToRemove = sparse[entity];
+    std::size_t indexToRemove = sparse.find(entity.index);
     dense[indexToRemove] = lastEntity;
     dense.pop_back();
 
-    components[indexToRemove] = components.back();
-    components.pop_back();
+    components.erase(indexToRemove);
 
-    sparse[lastEntity] = indexToRemove;
-    sparse[entity] = INVALID_ENTITY;
+    added_ticks[indexToRemove] = added_ticks.back();
+    added_ticks.pop_back();
+    changed_ticks[indexToRemove] = changed_ticks.back();
+    changed_ticks.pop_back();
+    added_at[indexToRemove] = added_at.back();
+    added_at.pop_back();
+    changed_at[indexToRemove] = changed_at.back();
+    changed_at.pop_back();
+
+    sparse.set(lastEntity.index, indexToRemove);
+    sparse.release(entity.index);
   }
 
   // Obtains a component belonging to an entity.
-  T *get(Entity entity) {
-    if (entity < sparse.size() && sparse[entity] != INVALID_ENTITY) {
-      return &components[sparse[entity]];
+  T *get(Entity entity)
+    requires(!IS_COLUMNAR)
+  {
+    std::size_t slot = sparse.find(entity.index);
+    if (slot != INVALID_INDEX && dense[slot] == entity) {
+      return components.data() + slot;
     }
 
     return nullptr;
   }
+
+  // Obtains a copy of a component stored as columns.
+  std::optional<T> load(Entity entity) const
+    requires IS_COLUMNAR
+  {
+    std::size_t slot = indexOf(entity);
+    if (slot == INVALID_INDEX) {
+      return std::nullopt;
+    }
+
+    return components.load(slot);
+  }
+
+  // Contiguous array for a field of a component stored as columns, packed in
+  // the same order as entities().
+  template <std::size_t I>
+  auto *column()
+    requires IS_COLUMNAR
+  {
+    return components.template column<I>();
+  }
+
+  // Checks if the entity has a component in the set. Stale handles fail the
+  // generation comparison against the stored handle.
+  bool contains(Entity entity) const override {
+    std::size_t slot = sparse.find(entity.index);
+    return slot != INVALID_INDEX && dense[slot] == entity;
+  }
+
+  // Amount of components stored.
+  std::size_t size() const override { return dense.size(); }
+
+  // Dense position of an entity's component, or INVALID_INDEX.
+  std::size_t indexOf(Entity entity) const override {
+    std::size_t slot = sparse.find(entity.index);
+    return slot != INVALID_INDEX && dense[slot] == entity ? slot
+                                                          : INVALID_INDEX;
+  }
+
+  // Exchanges two dense positions along with their stamps.
+  void swapSlots(std::size_t a, std::size_t b) override {
+    if (a == b) {
+      return;
+    }
+
+    std::swap(dense[a], dense[b]);
+    components.swap(a, b);
+    std::swap(added_ticks[a], added_ticks[b]);
+    std::swap(changed_ticks[a], changed_ticks[b]);
+    std::swap(added_at[a], added_at[b]);
+    std::swap(changed_at[a], changed_at[b]);
+    sparse.set(dense[a].index, a);
+    sparse.set(dense[b].index, b);
+  }
+
+  // Components packed in the same order as entities().
+  T *data()
+    requires(!IS_COLUMNAR)
+  {
+    return components.data();
+  }
+
+  // Entities owning a component, packed in the same order as the components.
+  const std::vector<Entity> &entities() const override { return dense; }
+
+  // Paged index of entities to components.
+  const SparseIndex &index() const { return sparse; }
+
+  // Tick the component of an entity was added or last changed at, assumes the
+  // entity is contained.
+  Tick addedTick(Entity entity) const {
+    return added_ticks[sparse.find(entity.index)];
+  }
+
+  Tick changedTick(Entity entity) const {
+    return changed_ticks[sparse.find(entity.index)];
+  }
+
+  // Additions and changes, ordered by tick. Entries may refer to components
+  // that have since been removed or stamped again.
+  const std::vector<Stamp> &addedLog() const { return added_log; }
+  const std::vector<Stamp> &changedLog() const { return changed_log; }
+
+  // Checks if the stamp at the position of a log is the latest stamp of a
+  // component that still exists.
+  bool isLatestAdded(std::size_t position) const {
+    std::size_t slot = indexOf(added_log[position].entity);
+    return slot != INVALID_INDEX &&
+           added_at[slot] == added_trimmed + position;
+  }
+
+  bool isLatestChanged(std::size_t position) const {
+    std::size_t slot = indexOf(changed_log[position].entity);
+    return slot != INVALID_INDEX &&
+           changed_at[slot] == changed_trimmed + position;
+  }
+
+  // Discards additions and changes at or before the tick.
+  void trim(Tick tick) override {
+    auto expired = [tick](const Stamp &stamp) { return stamp.tick <= tick; };
+    auto added_end =
+        std::partition_point(added_log.begin(), added_log.end(), expired);
+    auto changed_end =
+        std::partition_point(changed_log.begin(), changed_log.end(), expired);
+    added_trimmed += added_end - added_log.begin();
+    changed_trimmed += changed_end - changed_log.begin();
+    added_log.erase(added_log.begin(), added_end);
+    changed_log.erase(changed_log.begin(), changed_end);
+  }
 };
 
+// Creates an empty pool for a component type.
+template <typename T> std::unique_ptr<BaseSet> makeSet() {
+  return std::make_unique<SparseSet<T>>();
+}
+
 } // namespace ecs
 
 #endif
\ No newline at end of file
@@ -0,0 +1,146 @@
+#ifndef _ECS_STORAGE_HPP
+#define _ECS_STORAGE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+
+// Opt-in structure-of-arrays layout for trivially copyable components.
+// Specializing it with the members of a component stores each member in its
+// own contiguous array instead of storing whole components:
+//
+//   template <> struct soa_layout<Velocity> {
+//     static constexpr auto fields = std::make_tuple(&Velocity::x,
+//                                                    &Velocity::y);
+//   };
+template <typename T> struct soa_layout {};
+
+// Reserves room for at least n elements. Grows at least geometrically, an
+// exact reserve per batch would reallocate on every batch.
+template <typename V> void reserveAtLeast(V &vector, std::size_t n) {
+  if (vector.capacity() < n) {
+    vector.reserve(std::max(n, 2 * vector.capacity()));
+  }
+}
+
+template <typename T>
+concept SoALayout = requires { soa_layout<T>::fields; } &&
+                    std::is_trivially_copyable_v<T> &&
+                    std::is_default_constructible_v<T>;
+
+// Components stored contiguously as whole structures.
+template <typename T> class PackedStorage {
+public:
+  void push(const T &component) { components.push_back(component); }
+  void assign(std::size_t i, const T &component) { components[i] = component; }
+  void swap(std::size_t a, std::size_t b) {
+    std::swap(components[a], components[b]);
+  }
+
+  // Replaces position i with the last component.
+  void erase(std::size_t i) {
+    components[i] = std::move(components.back());
+    components.pop_back();
+  }
+
+  void reserve(std::size_t n) { reserveAtLeast(components, n); }
+  T *data() { return components.data(); }
+
+private:
+  std::vector<T> components;
+};
+
+namespace internal {
+template <typename M> struct member_type;
+template <typename C, typename F> struct member_type<F C::*> {
+  using type = F;
+};
+
+template <typename Fields> struct columns_for;
+template <typename... Ms> struct columns_for<std::tuple<Ms...>> {
+  using type = std::tuple<std::vector<typename member_type<Ms>::type>...>;
+};
+} // namespace internal
+
+// Components split into one contiguous array per field, declared through
+// soa_layout. Loops over a single field touch only that field's memory.
+template <SoALayout T> class ColumnStorage {
+  static constexpr auto fields = soa_layout<T>::fields;
+  using Fields = std::remove_cvref_t<decltype(fields)>;
+  static constexpr std::size_t COUNT = std::tuple_size_v<Fields>;
+
+public:
+  void push(const T &component) {
+    each([&](auto &column, auto field) {
+      column.push_back(component.*field);
+    });
+  }
+
+  void assign(std::size_t i, const T &component) {
+    each([&](auto &column, auto field) { column[i] = component.*field; });
+  }
+
+  void swap(std::size_t a, std::size_t b) {
+    each([&](auto &column, auto) { std::swap(column[a], column[b]); });
+  }
+
+  // Replaces position i with the last component.
+  void erase(std::size_t i) {
+    each([&](auto &column, auto) {
+      column[i] = column.back();
+      column.pop_back();
+    });
+  }
+
+  void reserve(std::size_t n) {
+    each([&](auto &column, auto) { reserveAtLeast(column, n); });
+  }
+
+  // Reassembles the component at position i.
+  T load(std::size_t i) const {
+    T component{};
+    each([&](const auto &column, auto field) { component.*field = column[i]; });
+    return component;
+  }
+
+  // Contiguous array for the field at index I of soa_layout<T>::fields.
+  template <std::size_t I> auto *column() {
+    return std::get<I>(columns).data();
+  }
+
+private:
+  typename internal::columns_for<Fields>::type columns;
+
+  // Invokes func(column, member pointer) for every field.
+  template <typename Func> void each(Func &&func) {
+    eachImpl(columns, func, std::make_index_sequence<COUNT>());
+  }
+
+  template <typename Func> void each(Func &&func) const {
+    eachImpl(columns, func, std::make_index_sequence<COUNT>());
+  }
+
+  template <typename Columns, typename Func, std::size_t... Is>
+  static void eachImpl(Columns &columns, Func &func,
+                       std::index_sequence<Is...>) {
+    (func(std::get<Is>(columns), std::get<Is>(fields)), ...);
+  }
+};
+
+// Storage selected for a component type.
+template <typename T> struct storage_for {
+  using type = PackedStorage<T>;
+};
+
+template <SoALayout T> struct storage_for<T> {
+  using type = ColumnStorage<T>;
+};
+
+} // namespace ecs
+
+#endif
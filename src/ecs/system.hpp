@@ -0,0 +1,89 @@
+#ifndef _ECS_SYSTEM_HPP
+#define _ECS_SYSTEM_HPP
+
+#include "component.hpp"
+#include "sparse.hpp"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace ecs {
+
+// Declares the components and map data a system reads and writes. Systems
+// whose access does not conflict are allowed to run at the same time.
+class Access {
+public:
+  // Creates a pool for a component type, used to ensure pools exist before
+  // systems that share them run concurrently.
+  using PoolFactory = std::unique_ptr<BaseSet> (*)();
+
+  // Access that conflicts with every other system, forcing it to run alone.
+  static Access exclusive() {
+    Access access;
+    access.is_exclusive = true;
+    return access;
+  }
+
+  // Declares components that are only read.
+  template <typename... Ts> Access &read() {
+    (declare<Ts>(reads), ...);
+    return *this;
+  }
+
+  // Declares components that are modified.
+  template <typename... Ts> Access &write() {
+    (declare<Ts>(writes), ...);
+    return *this;
+  }
+
+  // Declares the map is only read.
+  Access &readMap() {
+    map_read = true;
+    return *this;
+  }
+
+  // Declares the map is modified.
+  Access &writeMap() {
+    map_write = true;
+    return *this;
+  }
+
+  // Checks if two systems must not run at the same time.
+  bool conflicts(const Access &other) const {
+    if (is_exclusive || other.is_exclusive) {
+      return true;
+    } else if ((map_write && (other.map_read || other.map_write)) ||
+               (other.map_write && map_read)) {
+      return true;
+    }
+
+    return overlaps(writes, other.writes) || overlaps(writes, other.reads) ||
+           overlaps(reads, other.writes);
+  }
+
+  // Pools that are accessed, paired with a factory to create them.
+  const std::vector<std::pair<ComponentId, PoolFactory>> &pools() const {
+    return factories;
+  }
+
+private:
+  std::vector<ComponentId> reads, writes;
+  std::vector<std::pair<ComponentId, PoolFactory>> factories;
+  bool map_read = false, map_write = false, is_exclusive = false;
+
+  template <typename T> void declare(std::vector<ComponentId> &ids) {
+    ids.push_back(componentId<T>());
+    factories.emplace_back(componentId<T>(), &makeSet<T>);
+  }
+
+  static bool overlaps(const std::vector<ComponentId> &a,
+                       const std::vector<ComponentId> &b) {
+    return std::any_of(a.begin(), a.end(), [&b](ComponentId id) {
+      return std::find(b.begin(), b.end(), id) != b.end();
+    });
+  }
+};
+
+} // namespace ecs
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef _ECS_VIEW_HPP
+#define _ECS_VIEW_HPP
+
+#include "sparse.hpp"
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+namespace ecs {
+
+// Non-owning query over every entity that has all of the components Ts.
+// Iterates the dense array of the smallest pool and probes the rest, so the
+// cost scales with the smallest pool rather than the total entity count.
+template <typename... Ts> class View {
+  static_assert(sizeof...(Ts) > 0, "View requires at least one component");
+  static_assert((!SparseSet<Ts>::IS_COLUMNAR && ...),
+                "View requires components stored as whole structures");
+
+public:
+  using value_type = std::tuple<Entity, Ts *...>;
+
+  class Iterator {
+  public:
+    Iterator(const View *view, std::size_t index) : view(view), index(index) {
+      skip();
+    }
+
+    value_type operator*() const {
+      Entity entity = (*view->lead)[index];
+      return std::apply(
+          [entity](auto *...sets) {
+            return value_type(entity, sets->get(entity)...);
+          },
+          view->sets);
+    }
+
+    Iterator &operator++() {
+      index++;
+      skip();
+      return *this;
+    }
+
+    friend bool operator==(const Iterator &a, const Iterator &b) {
+      return a.index == b.index;
+    }
+
+    friend bool operator!=(const Iterator &a, const Iterator &b) {
+      return !(a == b);
+    }
+
+  private:
+    const View *view;
+    std::size_t index;
+
+    // Advances past entities that are missing one of the components.
+    void skip() {
+      while (index < view->lead->size() &&
+             !view->contains((*view->lead)[index])) {
+        index++;
+      }
+    }
+  };
+
+  explicit View(SparseSet<Ts> &...sets) : sets(&sets...) {
+    // Lead with the smallest pool to minimize the amount of probing.
+    std::array<const std::vector<Entity> *, sizeof...(Ts)> candidates = {
+        &sets.entities()...};
+    lead = candidates[0];
+    for (const auto *candidate : candidates) {
+      if (candidate->size() < lead->size()) {
+        lead = candidate;
+      }
+    }
+  }
+
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, lead->size()); }
+
+  // Upper bound of entities that will be visited.
+  std::size_t sizeHint() const { return lead->size(); }
+
+  // Invokes func(entity, Ts*...) for every matching entity.
+  template <typename Func> void each(Func &&func) const {
+    for (auto &&row : *this) {
+      std::apply(func, row);
+    }
+  }
+
+private:
+  std::tuple<SparseSet<Ts> *...> sets;
+  const std::vector<Entity> *lead; // Dense array being iterated.
+
+  // Checks if the entity is present in every pool.
+  bool contains(Entity entity) const {
+    return std::apply(
+        [entity](auto *...sets) { return (sets->contains(entity) && ...); },
+        sets);
+  }
+};
+
+} // namespace ecs
+
+#endif
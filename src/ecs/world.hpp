@@ -2,49 +2,182 @@
 #define _ECS_WORLD_HPP
 
 #include "../map/map.hpp"
+#include "../util/threadpool.hpp"
+#include "changes.hpp"
+#include "commands.hpp"
+#include "group.hpp"
 #include "sparse.hpp"
+#include "system.hpp"
+#include "view.hpp"
+#include <algorithm>
 #include <cassert>
+#include <exception>
 #include <functional>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <thread>
 #include <tuple>
-#include <typeindex>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace ecs {
 
 class World {
 private:
-  Entity next_id = INVALID_ENTITY + 1; // Next entity id.
-  std::vector<Entity> entities;        // All entities tracked.
-  std::vector<std::function<void(World &, MapData &)>> systems;
+  // A registered system, the data it accesses, and its deferred changes.
+  struct System {
+    std::function<void(World &, MapData &)> run;
+    Access access;
+    CommandBuffer commands;
+    Tick last_run = 0; // Tick the system last ran at.
+  };
 
-  // Component storage.
+  // Pools owned by a group. Entities with every component of the group are
+  // packed at the front of each pool, in the same order.
+  struct GroupData {
+    std::vector<ComponentId> ids;
+    std::size_t size = 0; // Amount of entities packed at the front.
+  };
+
+  std::vector<Entity> entities;            // Current handle for every index.
+  std::vector<std::uint32_t> free_indices; // Indices of destroyed entities.
+  std::vector<std::unique_ptr<BaseSet>> pools; // Indexed by ComponentId.
+
+  std::vector<std::unique_ptr<GroupData>> groups; // Declared owning groups.
+  std::vector<GroupData *> owners;                // Group owning each pool.
+
+  std::vector<System> systems;                  // In registration order.
+  std::vector<std::vector<std::size_t>> stages; // Concurrent system groups.
+  bool stages_dirty = false;                    // Stages need rebuilt.
+  std::unique_ptr<ThreadPool> workers;          // Created on first use.
+
+  CommandBuffer deferred; // Changes recorded outside of systems.
+  Tick change_tick = 1;   // Stamp for additions and changes.
+  Tick last_update = 0;   // Tick before the latest update started.
+
+  // Systems running on this thread with the world they run in, innermost
+  // last. Keyed by world so a system touching another world does not see
+  // itself as that world's running system.
+  static inline thread_local std::vector<std::pair<const World *, System *>>
+      running;
+
+  // System of this world running on this thread, if any.
+  System *active() const {
+    for (auto it = running.rbegin(); it != running.rend(); ++it) {
+      if (it->first == this) {
+        return it->second;
+      }
+    }
+
+    return nullptr;
+  }
+
+  // Component storage, created on first use.
   template <typename T> SparseSet<T> &getComponentSet() {
-    static std::unordered_map<std::type_index, void *> components;
-    auto type = std::type_index(typeid(T));
-    if (components.find(type) == components.end()) {
-      components[type] = new SparseSet<T>();
+    ComponentId id = componentId<T>();
+    if (id >= pools.size()) {
+      pools.resize(id + 1);
+    }
+
+    if (!pools[id]) {
+      pools[id] = std::make_unique<SparseSet<T>>();
     }
 
-    return *static_cast<SparseSet<T> *>(components[type]);
+    return *static_cast<SparseSet<T> *>(pools[id].get());
   }
 
 public:
-  // Create a new entity.
+  // Create a new entity, recycling the index of a destroyed one if possible.
   Entity createEntity() {
-    Entity entity = next_id++;
+    if (!free_indices.empty()) {
+      std::uint32_t index = free_indices.back();
+      free_indices.pop_back();
+      entities[index].index = index;
+      return entities[index];
+    }
+
+    Entity entity{static_cast<std::uint32_t>(entities.size()), 0};
     entities.push_back(entity);
     return entity;
   }
 
+  // Creates many entities at once, recycling destroyed indices first.
+  std::vector<Entity> createEntities(std::size_t n) {
+    std::vector<Entity> created;
+    created.reserve(n);
+    std::size_t recycled = std::min(n, free_indices.size());
+    reserveAtLeast(entities, entities.size() + n - recycled);
+    for (std::size_t i = 0; i < n; i++) {
+      created.push_back(createEntity());
+    }
+
+    return created;
+  }
+
+  // Destroys an entity and all of its components. Existing handles to the
+  // entity become stale and the index is reused by later entities.
+  void destroyEntity(Entity entity) {
+    if (!isAlive(entity)) {
+      return;
+    }
+
+    for (auto &group : groups) {
+      leaveGroup(*group, entity);
+    }
+
+    for (auto &pool : pools) {
+      if (pool) {
+        pool->remove(entity);
+      }
+    }
+
+    // Invalidate the slot and advance the generation for the next owner.
+    std::uint32_t generation = entity.generation + 1;
+    if (generation == CommandBuffer::PLACEHOLDER) {
+      generation = 0;
+    }
+
+    entities[entity.index] = {Entity::INVALID_INDEX, generation};
+    free_indices.push_back(entity.index);
+  }
+
+  // Checks if the handle refers to an entity that has not been destroyed.
+  bool isAlive(Entity entity) const {
+    return entity.index < entities.size() && entities[entity.index] == entity;
+  }
+
   // Add an entity and component.
   template <typename T, typename... Args>
   void addComponent(Entity entity, Args &&...args) {
-    getComponentSet<T>().add(entity, T(std::forward<Args>(args)...));
+    assert(isAlive(entity));
+    getComponentSet<T>().add(entity, T(std::forward<Args>(args)...),
+                             change_tick);
+    if (GroupData *group = ownerOf(componentId<T>())) {
+      enterGroup(*group, entity);
+    }
+  }
+
+  // Adds a component to each entity, entities[i] receiving components[i].
+  // Space for the whole batch is reserved upfront.
+  template <typename T>
+  void addComponents(std::span<const Entity> batch,
+                     std::span<const T> components) {
+    assert(batch.size() == components.size());
+    getComponentSet<T>().add(batch, components, change_tick);
+    if (GroupData *group = ownerOf(componentId<T>())) {
+      for (Entity entity : batch) {
+        enterGroup(*group, entity);
+      }
+    }
   }
 
   // Removes a component from an entity.
   template <typename T> void removeComponent(Entity entity) {
+    if (GroupData *group = ownerOf(componentId<T>())) {
+      leaveGroup(*group, entity);
+    }
+
     getComponentSet<T>().remove(entity);
   }
 
@@ -53,47 +186,320 @@ public:
     return getComponentSet<T>().get(entity);
   }
 
-  // Function to query entities that have both A and B components.
-  template <typename A> std::vector<std::tuple<Entity, A *>> getComponents() {
-    std::vector<std::tuple<Entity, A *>> result;
-    for (auto entity : entities) {
-      A *a = getComponent<A>(entity);
-      if (a) {
-        result.emplace_back(entity, a);
-      }
+  // Obtains the pool of a component type, used to operate on components
+  // stored as columns.
+  template <typename T> SparseSet<T> &pool() { return getComponentSet<T>(); }
+
+  // Iterates all entities that have every component Ts without allocating.
+  // Components must not be added or removed while the view is iterated.
+  template <typename... Ts> View<Ts...> view() {
+    return View<Ts...>(getComponentSet<Ts>()...);
+  }
+
+  // Iterates all entities that have every component Ts as a linear walk over
+  // the pools. The first call declares the group, after which the World keeps
+  // the pools aligned; a pool can only be owned by one group. Groups should be
+  // declared before systems run concurrently.
+  template <typename... Ts> Group<Ts...> group() {
+    std::vector<ComponentId> ids = {componentId<Ts>()...};
+    GroupData *group = ownerOf(ids[0]);
+    if (!group) {
+      (getComponentSet<Ts>(), ...);
+      group = declareGroup(ids);
+    } else if (group->ids.size() != ids.size() ||
+               !std::is_permutation(ids.begin(), ids.end(),
+                                    group->ids.begin())) {
+      throw std::runtime_error("Component is already owned by another group.");
     }
 
-    return result;
+    return Group<Ts...>(group->size, getComponentSet<Ts>()...);
   }
 
-  // Function to query entities that have both A and B components.
-  template <typename A, typename B>
-  std::vector<std::tuple<Entity, A *, B *>> getComponents() {
-    std::vector<std::tuple<Entity, A *, B *>> result;
-    for (auto entity : entities) {
-      A *a = getComponent<A>(entity);
-      B *b = getComponent<B>(entity);
-      if (a && b) {
-        result.emplace_back(entity, a, b);
-      }
+  // Snapshot of all entities that have every component Ts.
+  template <typename... Ts>
+  std::vector<std::tuple<Entity, Ts *...>> getComponents() {
+    auto query = view<Ts...>();
+    std::vector<std::tuple<Entity, Ts *...>> result;
+    result.reserve(query.sizeHint());
+    for (auto row : query) {
+      result.push_back(row);
     }
 
     return result;
   }
 
-  // Adds a new system to the world.
+  // Adds a new system to the world. Systems without declared access run
+  // alone, in the order they were added.
   void addSystem(std::function<void(World &, MapData &)> system) {
-    systems.push_back(system);
+    addSystem(system, Access::exclusive());
+  }
+
+  // Adds a new system that only touches the components and map data declared
+  // in access. Non-conflicting systems are ran at the same time on a worker
+  // pool, conflicting systems keep their order of registration.
+  void addSystem(std::function<void(World &, MapData &)> system,
+                 Access access) {
+    // Pools are created upfront since creating them is not thread-safe.
+    for (const auto &[id, factory] : access.pools()) {
+      if (id >= pools.size()) {
+        pools.resize(id + 1);
+      }
+
+      if (!pools[id]) {
+        pools[id] = factory();
+      }
+    }
+
+    systems.push_back({system, std::move(access), CommandBuffer()});
+    stages_dirty = true;
+  }
+
+  // Buffer to record structural changes into. Inside a system this is the
+  // buffer of that system, applied once its stage completes. Outside of a
+  // system the changes are applied at the end of the next update.
+  CommandBuffer &commands() {
+    System *system = active();
+    return system ? system->commands : deferred;
+  }
+
+  // Current tick, advanced before every stage and sync point of an update.
+  Tick tick() const { return change_tick; }
+
+  // Stamps a component of the entity as changed. Components modified through
+  // a pointer must be marked to be seen by changed().
+  template <typename T> void markChanged(Entity entity) {
+    getComponentSet<T>().markChanged(entity, change_tick);
+  }
+
+  // Entities whose component T was added after the tick. Inside a system the
+  // tick defaults to the last time that system ran.
+  template <typename T> Changes<T> added() { return added<T>(lastRun()); }
+  template <typename T> Changes<T> added(Tick since) {
+    return Changes<T>(getComponentSet<T>(), Changes<T>::Kind::Added, since);
+  }
+
+  // Entities whose component T was added or changed after the tick. Inside a
+  // system the tick defaults to the last time that system ran.
+  template <typename T> Changes<T> changed() { return changed<T>(lastRun()); }
+  template <typename T> Changes<T> changed(Tick since) {
+    return Changes<T>(getComponentSet<T>(), Changes<T>::Kind::Changed, since);
+  }
+
+  // Checks if the component of an entity was added or changed after the tick.
+  template <typename T> bool isChanged(Entity entity, Tick since) {
+    SparseSet<T> &set = getComponentSet<T>();
+    return set.contains(entity) && set.changedTick(entity) > since;
+  }
+
+  // Applies and clears all commands recorded in a buffer.
+  void apply(CommandBuffer &buffer) {
+    if (buffer.empty()) {
+      return;
+    }
+
+    change_tick++;
+    std::vector<Entity> created = createEntities(buffer.pending);
+    for (auto &command : buffer.commands) {
+      command(*this, created);
+    }
+
+    buffer.clear();
   }
 
   // Processes all systems.
   void update(MapData &obj) {
-    for (auto &system : systems) {
-      system(*this, obj);
+    if (stages_dirty) {
+      buildStages();
+    }
+
+    // Changes every system has observed are no longer needed. Outside of
+    // systems only changes since the start of an update are guaranteed.
+    last_update = change_tick;
+    Tick observed = change_tick;
+    for (const auto &system : systems) {
+      observed = std::min(observed, system.last_run);
+    }
+
+    for (auto &pool : pools) {
+      if (pool) {
+        pool->trim(observed);
+      }
+    }
+
+    for (const auto &stage : stages) {
+      change_tick++;
+      runStage(stage, obj);
+
+      // Sync point, structural changes are applied in registration order.
+      for (std::size_t id : stage) {
+        apply(systems[id].commands);
+      }
+    }
+
+    apply(deferred);
+
+    // Changes made between updates are stamped after every system ran.
+    change_tick++;
+  }
+
+private:
+  // Group that owns the pool of a component, if any.
+  GroupData *ownerOf(ComponentId id) const {
+    return id < owners.size() ? owners[id] : nullptr;
+  }
+
+  // Creates a group over the pools and packs the entities that already have
+  // every component.
+  GroupData *declareGroup(const std::vector<ComponentId> &ids) {
+    for (ComponentId id : ids) {
+      if (ownerOf(id)) {
+        throw std::runtime_error("Component is already owned by a group.");
+      }
+    }
+
+    groups.push_back(std::make_unique<GroupData>());
+    GroupData *group = groups.back().get();
+    group->ids = ids;
+    for (ComponentId id : ids) {
+      if (id >= owners.size()) {
+        owners.resize(id + 1, nullptr);
+      }
+
+      owners[id] = group;
+    }
+
+    // Entities move towards the front only, so none are skipped.
+    const std::vector<Entity> &members = pools[ids[0]]->entities();
+    for (std::size_t i = 0; i < members.size(); i++) {
+      enterGroup(*group, members[i]);
+    }
+
+    return group;
+  }
+
+  // Moves an entity into the packed region once it has every component.
+  void enterGroup(GroupData &group, Entity entity) {
+    std::size_t slot = pools[group.ids[0]]->indexOf(entity);
+    if (slot == INVALID_INDEX || slot < group.size) {
+      return;
+    }
+
+    for (ComponentId id : group.ids) {
+      if (!pools[id]->contains(entity)) {
+        return;
+      }
+    }
+
+    for (ComponentId id : group.ids) {
+      pools[id]->swapSlots(pools[id]->indexOf(entity), group.size);
     }
+
+    group.size++;
+  }
+
+  // Moves an entity out of the packed region before one of its components is
+  // removed.
+  void leaveGroup(GroupData &group, Entity entity) {
+    std::size_t slot = pools[group.ids[0]]->indexOf(entity);
+    if (slot == INVALID_INDEX || slot >= group.size) {
+      return;
+    }
+
+    group.size--;
+    for (ComponentId id : group.ids) {
+      pools[id]->swapSlots(pools[id]->indexOf(entity), group.size);
+    }
+  }
+
+  // Runs every system in a stage, distributing them across the workers.
+  void runStage(const std::vector<std::size_t> &stage, MapData &obj) {
+    if (stage.size() == 1) {
+      runSystem(systems[stage[0]], obj);
+      return;
+    }
+
+    if (!workers) {
+      std::size_t threads = std::thread::hardware_concurrency();
+      workers =
+          std::make_unique<ThreadPool>(std::max<std::size_t>(threads, 2) - 1);
+    }
+
+    // Errors are kept per system so the stage always finishes and the one
+    // rethrown does not depend on which thread failed first.
+    std::vector<std::exception_ptr> errors(stage.size());
+    auto run = [this, &stage, &errors, &obj](std::size_t i) {
+      try {
+        runSystem(systems[stage[i]], obj);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    };
+
+    // The calling thread takes the first system of the stage.
+    for (std::size_t i = 1; i < stage.size(); i++) {
+      workers->submit([&run, i] { run(i); });
+    }
+
+    run(0);
+    workers->wait();
+    for (const std::exception_ptr &error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+  }
+
+  // Runs a single system with its command buffer active on this thread.
+  void runSystem(System &system, MapData &obj) {
+    running.push_back({this, &system});
+    try {
+      system.run(*this, obj);
+    } catch (...) {
+      running.pop_back();
+      throw;
+    }
+
+    system.last_run = change_tick;
+    running.pop_back();
+  }
+
+  // Tick the running system last ran at. Outside of a system this is the
+  // tick before the latest update.
+  Tick lastRun() const {
+    System *system = active();
+    return system ? system->last_run : last_update;
+  }
+
+  // Groups systems into stages. A system is placed in the stage after the
+  // latest earlier system it conflicts with.
+  void buildStages() {
+    std::vector<std::size_t> level(systems.size(), 0);
+    stages.clear();
+
+    for (std::size_t i = 0; i < systems.size(); i++) {
+      for (std::size_t j = 0; j < i; j++) {
+        if (systems[i].access.conflicts(systems[j].access)) {
+          level[i] = std::max(level[i], level[j] + 1);
+        }
+      }
+
+      if (level[i] >= stages.size()) {
+        stages.resize(level[i] + 1);
+      }
+
+      stages[level[i]].push_back(i);
+    }
+
+    stages_dirty = false;
   }
 };
 
+inline void CommandBuffer::destroyEntity(Entity entity) {
+  commands.push_back([entity](World &world, const Created &created) {
+    world.destroyEntity(resolve(entity, created));
+  });
+}
+
 } // namespace ecs
 
 #endif
@@ -2,6 +2,10 @@
 #define _WAVE_FUNCTION_COLLAPSE_RULESET_HPP
 
 #include <algorithm>
+#include <bit>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <random>
 #include <sstream>
@@ -10,6 +14,12 @@
 
 namespace wfc {
 
+// Largest amount of rules in a ruleset, the width of a cell's domain.
+inline constexpr std::size_t MAX_STATES = 64;
+
+// Set of possible states, bit i is the rule at index i of the ruleset.
+using Domain = std::bitset<MAX_STATES>;
+
 template <typename T> class Rule {
 public:
   Rule(int weight, const std::vector<std::vector<T>> &data)
@@ -36,7 +46,7 @@ public:
   // Retrieves a rule by ID. Throws std::out_of_range if the ID is not found.
   const Rule<T> &getRule(T id) const { return rules.at(id); }
 
-  // Adds a new rule to the ruleset.
+  // Adds a new rule to the ruleset, compile() has to be called afterwards.
   void addRule(T id, int weight, std::vector<std::vector<T>> data) {
     for (auto &vec : data) {
       std::sort(vec.begin(), vec.end());
@@ -46,6 +56,79 @@ public:
                   std::forward_as_tuple(weight, data));
   }
 
+  // Numbers the rules from 0 in id order and builds, for every rule and
+  // direction, the mask of rules allowed next to it.
+  void compile() {
+    ids = allRules();
+    if (ids.size() > MAX_STATES) {
+      throw std::runtime_error("Too many rules for the ruleset.");
+    }
+
+    masks.assign(ids.size() * 4, Domain());
+    weights.clear();
+    for (std::size_t i = 0; i < ids.size(); i++) {
+      const Rule<T> &rule = rules.at(ids[i]);
+      weights.push_back(rule.weight());
+      for (int dir = 0; dir < 4; dir++) {
+        for (const T &linked : rule.atDirection(dir)) {
+          masks[i * 4 + dir].set(indexOf(linked));
+        }
+      }
+    }
+  }
+
+  // Amount of compiled rules.
+  std::size_t size() const { return ids.size(); }
+
+  // Rule id of a compiled index.
+  const T &stateOf(std::size_t index) const { return ids[index]; }
+
+  // Compiled index of a rule id.
+  std::size_t indexOf(const T &id) const {
+    auto found = std::lower_bound(ids.begin(), ids.end(), id);
+    if (found == ids.end() || *found != id) {
+      throw std::out_of_range("Rule is not part of the ruleset.");
+    }
+
+    return found - ids.begin();
+  }
+
+  // Domain containing every compiled rule.
+  Domain allStates() const {
+    Domain all;
+    for (std::size_t i = 0; i < ids.size(); i++) {
+      all.set(i);
+    }
+
+    return all;
+  }
+
+  // Rules allowed in the direction of the rule at the compiled index.
+  const Domain &allowed(std::size_t index, int direction) const {
+    return masks[index * 4 + direction];
+  }
+
+  // Selects a compiled index from the domain, determined by the weights.
+  std::size_t pickState(std::mt19937 &rng, const Domain &domain) const {
+    std::uint64_t bits = domain.to_ullong();
+    long long total = 0;
+    for (std::uint64_t rest = bits; rest != 0; rest &= rest - 1) {
+      total += weights[std::countr_zero(rest)];
+    }
+
+    std::uniform_int_distribution<long long> dist(0, total - 1);
+    long long roll = dist(rng);
+    for (std::uint64_t rest = bits; rest != 0; rest &= rest - 1) {
+      std::size_t index = std::countr_zero(rest);
+      roll -= weights[index];
+      if (roll < 0) {
+        return index;
+      }
+    }
+
+    return std::countr_zero(bits);
+  }
+
   // Obtains all possible rules.
   std::vector<T> allRules() const {
     std::vector<T> all_rules;
@@ -133,12 +216,18 @@ public:
     rules.addRule(32, CI, {{30, 31, 29}, {19}, {19}, {21, 31, 23}}); // NWR
 
     rules.validate();
+    rules.compile();
     return rules;
   }
 
 private:
   std::map<T, Rule<T>> rules;
 
+  // Compiled form of the rules.
+  std::vector<T> ids;        // Rule id of every index, sorted.
+  std::vector<Domain> masks; // Allowed neighbors per index and direction.
+  std::vector<int> weights;  // Weight of every index.
+
   // Gets the opposite direction. 0 <-> 2, 1 <-> 3
   int oppositeDirection(int direction) { return (direction + 2) % 4; }
 };
@@ -3,14 +3,18 @@
 
 #include "ruleset.hpp"
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
-#include <limits>
 #include <map>
 #include <optional>
 #include <random>
-#include <set>
 #include <stack>
+#include <stdexcept>
 #include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -18,26 +22,22 @@ namespace wfc {
 
 template <typename T> class Cell {
 public:
-  std::vector<T> states; // All currently possible states.
-
-  Cell(std::vector<T> states) : states(states) {}
-
-  T state() { return states[0]; }               // State collapsed to.
-  int entropy() { return states.size(); }       // Entropy of the cell.
-  bool isCollapsed() { return entropy() == 1; } // Collapsed status.
-  bool isInvalid() { return entropy() == 0; }   // Check if in invalid state.
-
-  // Constrains the cell to abide by rules.
-  bool constrain(std::vector<T> constraints) {
-    // Prepare a vector to hold the intersection.
-    std::vector<int> intersection;
-
-    // Calculate the intersection.
-    std::set_intersection(states.begin(), states.end(), constraints.begin(),
-                          constraints.end(), std::back_inserter(intersection));
-
-    if (states.size() != intersection.size()) {
-      states = intersection;
+  Domain domain; // All currently possible states, as compiled indices.
+  T value = T(); // State collapsed to, set once a single state remains.
+
+  Cell(Domain domain) : domain(domain) {}
+
+  // State collapsed to, only meaningful once the cell is collapsed.
+  T state() const { return value; }
+  int entropy() const { return domain.count(); }      // Entropy of the cell.
+  bool isCollapsed() const { return entropy() == 1; } // Collapsed status.
+  bool isInvalid() const { return domain.none(); }    // No states left.
+
+  // Constrains the cell to the allowed states, true if any were removed.
+  bool constrain(const Domain &allowed) {
+    Domain narrowed = domain & allowed;
+    if (narrowed != domain) {
+      domain = narrowed;
       return true;
     }
 
@@ -51,20 +51,52 @@ template <typename T> class WaveFunctionCollapse {
 public:
   WaveFunctionCollapse(std::mt19937 &rng, int height, int width,
                        Ruleset<T> &rules, bool wrap)
-      : rng(rng), wrap(wrap), rules(rules) {
-
-    // Initialize the wave.
-    std::vector<T> states = rules.allRules();
-    wave = Wave<T>(height, std::vector<Cell<T>>(width, Cell(states)));
+      : rng(rng), wrap(wrap), height(height), width(width), rules(rules) {
+    this->rules.compile();
+    reset();
   }
 
   // Obtains the current status of the wave.
   Wave<T> getWave() const { return wave; }
 
-  // Collapses the entire wave.
+  // Collapses the entire wave. A cell left without states cannot be
+  // resolved, the wave starts over with the generator where it left off.
+  // Throws if every attempt ends in a contradiction.
   void collapse() {
-    while (!isCollapsed()) {
-      next();
+    for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+      while (!isCollapsed()) {
+        next();
+      }
+
+      if (!isContradicted()) {
+        return;
+      }
+
+      reset();
+    }
+
+    throw std::runtime_error("Unable to collapse wave without contradiction.");
+  }
+
+  // Starts over with every state possible in every cell.
+  void reset() {
+    Cell<T> initial(rules.allStates());
+    if (initial.isCollapsed()) {
+      // A single state leaves nothing to collapse, set it upfront.
+      initial.value = rules.stateOf(std::countr_zero(
+          initial.domain.to_ullong()));
+    }
+
+    wave = Wave<T>(height, std::vector<Cell<T>>(width, initial));
+    to_proc = {};
+    done = contradicted = false;
+
+    // Every cell starts in the same bucket, in row-major order.
+    buckets.assign(MAX_STATES + 1, {});
+    bucket_of.assign(static_cast<std::size_t>(height) * width, 0);
+    slots.resize(bucket_of.size());
+    for (std::uint32_t i = 0; i < bucket_of.size(); i++) {
+      track(i, initial.entropy());
     }
   }
 
@@ -90,19 +122,69 @@ public:
       propagate(cx, cy);
     }
 
+    // A cell without states has no valid result, stop here.
+    if (contradicted) {
+      done = true;
+      return false;
+    }
+
     return true;
   }
 
-  // Checks if the wave is fully collapsed.
+  // Checks if the wave is finished, either collapsed or contradicted.
   bool isCollapsed() const { return done; }
 
+  // Checks if a cell was left without any states. Its state() is not a
+  // result and the wave has to be reset.
+  bool isContradicted() const { return contradicted; }
+
 private:
+  static constexpr int MAX_ATTEMPTS = 16; // Restarts before giving up.
+
   std::mt19937 rng; // Used to have consistent randomization.
   bool wrap = false, done = false;
+  bool contradicted = false; // A cell ran out of states.
+  int height, width;         // Dimensions of the wave.
   Wave<T> wave;     // Wave / Map / Grid
   Ruleset<T> rules; // Rules and constraints for propagation.
   std::stack<std::pair<int, int>> to_proc; // (x, y) that need propagated.
 
+  // Cells that can still be collapsed, bucketed by entropy so the lowest is
+  // found without scanning the wave. Updated whenever a cell is constrained.
+  std::vector<std::vector<std::uint32_t>> buckets; // Cells per entropy.
+  std::vector<std::uint8_t> bucket_of; // Bucket of each cell, 0 if none.
+  std::vector<std::uint32_t> slots;    // Position of each cell in its bucket.
+
+  // Adds the cell to the bucket of the entropy, if it can be collapsed.
+  void track(std::uint32_t cell, std::size_t entropy) {
+    bucket_of[cell] = entropy >= 2 ? entropy : 0;
+    if (bucket_of[cell] != 0) {
+      slots[cell] = buckets[entropy].size();
+      buckets[entropy].push_back(cell);
+    }
+  }
+
+  // Removes the cell from its bucket by swapping in the last cell.
+  void untrack(std::uint32_t cell) {
+    if (bucket_of[cell] == 0) {
+      return;
+    }
+
+    std::vector<std::uint32_t> &bucket = buckets[bucket_of[cell]];
+    std::uint32_t last = bucket.back();
+    bucket[slots[cell]] = last;
+    slots[last] = slots[cell];
+    bucket.pop_back();
+    bucket_of[cell] = 0;
+  }
+
+  // Moves the cell (x, y) to the bucket of its current entropy.
+  void retrack(int x, int y) {
+    std::uint32_t cell = y * wave[0].size() + x;
+    untrack(cell);
+    track(cell, wave[y][x].entropy());
+  }
+
   // Collapses cell (x, y).
   void collapseCell(int x, int y) {
     Cell<T> &cell = wave[y][x];
@@ -110,133 +192,98 @@ private:
       return;
     }
 
-    cell.states = {rules.pickRule(rng, cell.states)};
+    std::size_t index = rules.pickState(rng, cell.domain);
+    cell.domain.reset();
+    cell.domain.set(index);
+    cell.value = rules.stateOf(index);
+    retrack(x, y);
   }
 
   // Propagates the possible states to neighboring cells.
   void propagate(int x, int y) {
-    Cell<T> &parent = wave[y][x];
+    std::uint64_t states = wave[y][x].domain.to_ullong();
+    auto [neighbors, count] = getNeighbors(x, y);
 
-    for (const auto &[nx, ny] : getNeighbors(x, y)) {
+    for (int i = 0; i < count; i++) {
+      const auto &[nx, ny, direction] = neighbors[i];
       Cell<T> &neighbor = wave[ny][nx];
-      if (neighbor.isCollapsed()) {
+      if (neighbor.isInvalid()) {
         continue;
       }
 
-      // Get the positioning relative to parent.
-      int position = getPosition(x, y, nx, ny);
-
-      std::set<int> all_states;
-      for (const int state : parent.states) {
-        // Accumulate all rules for the states.
-        for (const int new_state : rules.getRule(state).atDirection(position)) {
-          all_states.emplace(new_state);
-        }
+      // Collapsed neighbors are checked as well, two cells collapsing at
+      // once could otherwise settle on states that conflict.
+      // Accumulate all rules for the states.
+      Domain allowed;
+      for (std::uint64_t rest = states; rest != 0; rest &= rest - 1) {
+        allowed |= rules.allowed(std::countr_zero(rest), direction);
       }
 
-      // Concert to vector and sort.
-      std::vector<int> allowed(all_states.begin(), all_states.end());
-      std::sort(allowed.begin(), allowed.end());
-
       // Constrain neighbor to states rules.
       if (neighbor.constrain(allowed)) {
+        retrack(nx, ny);
+        if (neighbor.isInvalid()) {
+          // Spreading an empty domain would empty every cell around it.
+          contradicted = true;
+          continue;
+        } else if (neighbor.isCollapsed()) {
+          neighbor.value = rules.stateOf(std::countr_zero(
+              neighbor.domain.to_ullong()));
+        }
+
         to_proc.push({nx, ny});
       }
     }
   }
 
-  // Gets a random lowest entropy.
+  // Gets a random cell of the lowest entropy. Cells with no states left are
+  // not tracked, contradictions are left as is.
   std::optional<std::pair<int, int>> getMinEntropy() {
-    int min_entropy = std::numeric_limits<int>::max();
-    std::vector<std::pair<int, int>> candidates;
-
-    // Check the entire wave for lowest entropy.
-    for (int y = 0; y < wave.size(); y++) {
-      for (int x = 0; x < wave[y].size(); x++) {
-        auto &cell = wave[y][x];
-        if (!cell.isCollapsed() && cell.entropy() < min_entropy) {
-          min_entropy = cell.entropy();
-          candidates = {{x, y}};
-        } else if (cell.entropy() == min_entropy) {
-          candidates.push_back({x, y});
-        }
+    for (const std::vector<std::uint32_t> &bucket : buckets) {
+      if (bucket.empty()) {
+        continue;
       }
-    }
 
-    // No more cells to collapse.
-    if (candidates.empty()) {
-      return std::nullopt;
+      // Select a random cell.
+      std::uniform_int_distribution<std::size_t> dist(0, bucket.size() - 1);
+      std::uint32_t cell = bucket[dist(rng)];
+      int width = wave[0].size();
+      return std::pair<int, int>(cell % width, cell / width);
     }
 
-    // Select a random cell.
-    std::uniform_int_distribution<int> dist(0, candidates.size() - 1);
-    return candidates[dist(rng)];
+    // No more cells to collapse.
+    return std::nullopt;
   }
 
-  // Obtains the neighbors, respecting the wave borders. Randomizes the results.
-  std::vector<std::pair<int, int>> getNeighbors(int x, int y) {
-    std::vector<std::pair<int, int>> neighbors;
+  // Obtains the neighbors (x, y, direction) respecting the wave borders, and
+  // how many there are. Directions are North 0, East 1, South 2 and West 3.
+  std::pair<std::array<std::tuple<int, int, int>, 4>, int>
+  getNeighbors(int x, int y) const {
+    std::array<std::tuple<int, int, int>, 4> neighbors;
     int height = wave.size();
     int width = wave[0].size();
+    int count = 0;
 
-    // North (-1, 0), East (0, +1), South (+1, 0), West (0, -1).
-    std::array<std::pair<int, int>, 4> directions = {
-        {{0, 1}, {1, 0}, {0, -1}, {-1, 0}}};
+    // North (0, -1), East (+1, 0), South (0, +1), West (-1, 0).
+    static constexpr std::array<std::pair<int, int>, 4> directions = {
+        {{0, -1}, {1, 0}, {0, 1}, {-1, 0}}};
 
-    for (const auto &[dx, dy] : directions) {
-      int nx = x + dx;
-      int ny = y + dy;
+    for (int direction = 0; direction < 4; direction++) {
+      int nx = x + directions[direction].first;
+      int ny = y + directions[direction].second;
 
       if (wrap) {
         // Wrap around horizontally and vertically.
         nx = (nx + width) % width;
         ny = (ny + height) % height;
-        neighbors.push_back({nx, ny});
-      } else {
+        neighbors[count++] = {nx, ny, direction};
+      } else if (nx >= 0 && nx < width && ny >= 0 && ny < height) {
         // Ensure neighbors are within map boundaries.
-        if (nx >= 0 && nx < width && ny >= 0 && ny < height) {
-          neighbors.push_back({nx, ny});
-        }
+        neighbors[count++] = {nx, ny, direction};
       }
     }
 
-    // Shuffle neighbors to randomize processing order.
-    std::shuffle(neighbors.begin(), neighbors.end(), rng);
-    return neighbors;
-  }
-
-  // Get the position of (x2, y2) to (x1, y1)
-  int getPosition(int x1, int y1, int x2, int y2) {
-    int height = wave.size();
-    int width = wave[0].size();
-
-    // Calculate differences considering wrapping.
-    int dx = (x2 - x1 + width) % width;
-    int dy = (y2 - y1 + height) % height;
-
-    // Normalize dx and dy to -1, 0, or 1 for easier comparison.
-    if (dx > 0 && dx < width / 2)
-      dx = 1; // Right
-    else if (dx > width / 2)
-      dx = -1; // Left (wrapped)
-
-    if (dy > 0 && dy < height / 2)
-      dy = 1; // Down
-    else if (dy > height / 2)
-      dy = -1; // Up (wrapped)
-
-    // Return position index based on normalized dx and dy.
-    if (dx == 1 && dy == 0)
-      return 1; // East (right)
-    if (dx == -1 && dy == 0)
-      return 3; // West (left)
-    if (dy == 1 && dx == 0)
-      return 2; // South (down)
-    if (dy == -1 && dx == 0)
-      return 0; // North (up)
-
-    // Default return for non-cardinal directions or error.
-    return -1;
+    return {neighbors, count};
   }
 };
 } // namespace wfc
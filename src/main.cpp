@@ -4,7 +4,7 @@
 int main(int argc, char const *argv[]) {
   std::mt19937 rng(std::random_device{}());
   core::GameObject game(rng, 128, 128);
-  game.registerSystem(core::pathfinder);
+  game.registerSystem(core::pathfinder(game.paths), core::pathfinderAccess());
 
   game.start();
   return 0;
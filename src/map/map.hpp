@@ -4,14 +4,20 @@
 #include "../generation/terrain/wfc.hpp"
 #include "../pathfind/pathfind.hpp"
 #include "../tileset.hpp"
+#include "router.hpp"
 #include "tile.hpp"
+#include <deque>
+#include <functional>
 #include <memory>
 #include <queue>
 #include <random>
+#include <unordered_map>
 #include <vector>
 
 class MapData {
 public:
+  using MapField = pathfind::FlowField<pathfind::BitGridAccessor>;
+
   std::mt19937 rng;
   std::vector<std::shared_ptr<Tile>> data;
   int _width, _height;
@@ -27,6 +33,10 @@ public:
     applyWave(wfc.getWave());
   }
 
+  // Flow fields reference the passability grid owned by the map.
+  MapData(const MapData &) = delete;
+  MapData &operator=(const MapData &) = delete;
+
   int width() const { return _width; }
   int height() const { return _height; }
 
@@ -39,6 +49,42 @@ public:
     throw std::out_of_range("Index out of bounds for map data.");
   }
 
+  // Replaces the tile at position (x, y), keeping the passability grid in
+  // sync with the new tile.
+  void setTile(int x, int y, std::shared_ptr<Tile> tile) {
+    if (!inBounds(x, y)) {
+      throw std::out_of_range("Index out of bounds for map data.");
+    }
+
+    routes->set(x, y, tile->isOccupied());
+    data[y * _width + x] = std::move(tile);
+    fields.clear();
+    field_order.clear();
+  }
+
+  // Size of the largest square of passable tiles with its top-left corner at
+  // (x, y), 0 if the tile is occupied.
+  int getClearance(int x, int y) const {
+    if (!inBounds(x, y)) {
+      throw std::out_of_range("Index out of bounds for map data.");
+    }
+
+    return routes->getClearance(x, y);
+  }
+
+  // Passability of every tile, one bit per tile.
+  const pathfind::BitGrid &getPassability() const {
+    return routes->getPassability();
+  }
+
+  // Routing shared with searches running on other threads.
+  MapRouter &getRouter() { return *routes; }
+
+  // Checks if a path exists between two positions.
+  bool isConnected(const Vec2i &a, const Vec2i &b) const {
+    return routes->isConnected(a, b);
+  }
+
   // Check if the given position is within bounds.
   bool inBounds(int x, int y) const {
     return x >= 0 && x < _width && y >= 0 && y < _height;
@@ -59,30 +105,74 @@ public:
     }
   }
 
-  std::queue<Vec2i> pathfind(Vec2i src, Vec2i dest) {
-    // Check bounds and ensure movement is possible.
-    if (!inBounds(src.x, src.y) || !inBounds(dest.x, dest.y) ||
-        at(src.x, src.y)->isOccupied() || at(dest.x, dest.y)->isOccupied()) {
-      return std::queue<Vec2i>();
+  // Obtains the flow field leading every tile to the goal. Fields are cached
+  // per goal until the tiles change, the oldest is dropped once the cache is
+  // full. Held fields stay usable but are not updated.
+  std::shared_ptr<const MapField> flowField(const Vec2i &goal) {
+    if (!inBounds(goal.x, goal.y)) {
+      throw std::out_of_range("Index out of bounds for map data.");
+    }
+
+    std::size_t key = static_cast<std::size_t>(goal.y) * _width + goal.x;
+    if (auto found = fields.find(key); found != fields.end()) {
+      return found->second;
+    }
+
+    if (field_order.size() == MAX_FIELDS) {
+      fields.erase(field_order.front());
+      field_order.pop_front();
     }
 
-    // Wrap the map data for processing.
-    auto grid = std::make_unique<pathfind::LinearGrid<std::shared_ptr<Tile>>>(
-        data, _width);
+    auto field = std::make_shared<const MapField>(
+        pathfind::BitGridAccessor(getPassability()), std::vector<Vec2i>{goal});
+    fields.emplace(key, field);
+    field_order.push_back(key);
+    return field;
+  }
+
+  // Finds a path for an agent covering size x size tiles, positions are the
+  // top-left tile of the agent.
+  std::queue<Vec2i> pathfind(Vec2i src, Vec2i dest, int size = 1) {
+    return toQueue(routes->findPath(work, src, dest, size));
+  }
+
+  // Path to the closest tile accepted by is_goal, found with one search.
+  // Empty if none can be reached.
+  std::queue<Vec2i>
+  pathfindNearest(Vec2i src, const std::function<bool(const Tile &)> &is_goal) {
+    return toQueue(routes->findNearest(work, src, [&](const Vec2i &position) {
+      return is_goal(*data[position.y * _width + position.x]);
+    }));
+  }
+
+  // Path to the closest of the goals, found with one search. Goals in other
+  // regions are dropped before searching.
+  std::queue<Vec2i> pathfindNearest(Vec2i src,
+                                    const std::vector<Vec2i> &goals) {
+    return toQueue(routes->findNearest(work, src, goals));
+  }
+
+private:
+  using FieldCache =
+      std::unordered_map<std::size_t, std::shared_ptr<const MapField>>;
+
+  static constexpr std::size_t MAX_FIELDS = 16; // Flow fields cached.
 
-    pathfind::AStar<std::shared_ptr<Tile>> astar(std::move(grid), false);
+  std::unique_ptr<MapRouter> routes;   // Kept in sync with the tiles.
+  MapRouter::Workspace work;           // Search state for the map's queries.
+  FieldCache fields;                   // Flow fields by goal tile.
+  std::deque<std::size_t> field_order; // Cached goals, oldest first.
 
-    // Find the path using the A* algorithm.
-    std::vector<Vec2i> path_vec = astar.findPath(src, dest);
+  // Converts a path into the queue consumed by PathComponent.
+  static std::queue<Vec2i> toQueue(const std::vector<Vec2i> &path) {
     std::queue<Vec2i> path_queue;
-    for (auto &step : path_vec) {
+    for (auto &step : path) {
       path_queue.push(step);
     }
 
     return path_queue;
   }
 
-private:
   // Applies a collapsed wave and expands its results into a larger map.
   void applyWave(wfc::Wave<int> wave) {
     int height = wave.size();
@@ -97,6 +187,10 @@ private:
     // Fill the expanded map with tiles from tilesets.
     for (int i = 0; i < height; i++) {
       for (int j = 0; j < width; j++) {
+        if (!wave[i][j].isCollapsed()) {
+          throw std::runtime_error("Wave contains an unresolved cell.");
+        }
+
         std::vector<std::vector<int>> block =
             TileExpander::expand(rng, wave[i][j].state());
         for (int di = 0; di < new_size; di++) {
@@ -107,6 +201,16 @@ private:
         }
       }
     }
+
+    // Build the passability grid once, setTile keeps it updated.
+    pathfind::BitGrid passable(_width, _height);
+    for (int y = 0; y < _height; y++) {
+      for (int x = 0; x < _width; x++) {
+        passable.set(x, y, data[y * _width + x]->isOccupied());
+      }
+    }
+
+    routes = std::make_unique<MapRouter>(std::move(passable));
   }
 };
 
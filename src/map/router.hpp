@@ -0,0 +1,289 @@
+#ifndef _MAP_ROUTER_HPP
+#define _MAP_ROUTER_HPP
+
+#include "../pathfind/pathfind.hpp"
+#include "../tileset.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+// Routing over the passability of a map: connected regions, clusters for
+// distant goals, landmarks for the heuristic and clearance for larger
+// agents. Queries take a Workspace holding the search state of the caller,
+// threads with their own Workspace can search at the same time while tiles
+// are changed from another thread.
+class MapRouter {
+  using Accessor = pathfind::BitGridAccessor;
+  using Landmarks = pathfind::Landmarks<Accessor>;
+  using Heuristic = pathfind::LandmarkHeuristic<Landmarks>;
+  using Search = pathfind::BasicAStar<Accessor, Heuristic>;
+  using Hierarchy = pathfind::HierarchicalSearch<Accessor, Heuristic>;
+  using Regions = pathfind::ConnectedRegions<Accessor>;
+  using Clearance = pathfind::ClearanceMap<Accessor>;
+  using SizedSearch =
+      pathfind::BasicAStar<pathfind::ClearanceAccessor<Clearance>, Heuristic>;
+
+  // Clusters span whole WFC cells, 8x8 cells of expanded tiles.
+  static constexpr int CLUSTER_SIZE = TileExpander::DIMENSIONS * 8;
+  static constexpr std::size_t LANDMARKS = 8; // Landmarks for A*.
+
+public:
+  // Search state of one caller, reused between its queries.
+  class Workspace {
+  public:
+    // State of the latest search.
+    pathfind::SearchStatus getStatus() const { return status; }
+
+    // Cells expanded by the latest search over every resume().
+    std::size_t getExpanded() const { return expanded; }
+
+    // Path found by the latest search, empty until it is found.
+    const std::vector<Vec2i> &getPath() const { return path; }
+
+  private:
+    friend class MapRouter;
+
+    // How the search in progress is solved.
+    enum class Kind { Direct, Sized, Hierarchical };
+
+    std::unique_ptr<Search> direct;                              // 1x1.
+    std::unordered_map<int, std::unique_ptr<SizedSearch>> sized; // By size.
+    Hierarchy::Scratch clusters;
+
+    Kind kind = Kind::Direct;
+    SizedSearch *agent = nullptr; // Search for the size, if sized.
+    Vec2i src{0, 0}, dest{0, 0};
+    pathfind::SearchStatus status = pathfind::SearchStatus::NotFound;
+    std::size_t expanded = 0;
+    std::vector<Vec2i> path;
+  };
+
+  // Takes the passability of every tile, kept updated with set().
+  explicit MapRouter(pathfind::BitGrid passability)
+      : passable(std::move(passability)) {
+    Accessor grid(passable);
+    regions = std::make_unique<Regions>(grid);
+    landmarks = std::make_unique<Landmarks>(grid, LANDMARKS);
+    hierarchy = std::make_unique<Hierarchy>(grid, CLUSTER_SIZE,
+                                            Heuristic(*landmarks));
+    clearance = std::make_unique<Clearance>(grid);
+  }
+
+  // Structures refer to the passability grid owned by the router.
+  MapRouter(const MapRouter &) = delete;
+  MapRouter &operator=(const MapRouter &) = delete;
+
+  int getWidth() const { return passable.getWidth(); }   // Width of the map.
+  int getHeight() const { return passable.getHeight(); } // Height of the map.
+
+  // Passability of every tile. Not locked, only for the thread calling set().
+  const pathfind::BitGrid &getPassability() const { return passable; }
+
+  // Changes the passability of the tile at (x, y). Waits for searches that
+  // are reading the structures, each holds them for at most one resume().
+  void set(int x, int y, bool occupied) {
+    std::unique_lock guard(lock);
+    bool opened = passable.isOccupied(x, y) && !occupied;
+    passable.set(x, y, occupied);
+    regions->update(x, y);
+    clearance->update(x, y);
+    hierarchy->rebuild(x, y);
+    if (opened) {
+      stale.store(true, std::memory_order_release);
+    }
+  }
+
+  // Checks if a path exists between two positions.
+  bool isConnected(const Vec2i &a, const Vec2i &b) const {
+    std::shared_lock guard(lock);
+    return regions->isConnected(a, b);
+  }
+
+  // Size of the largest square of passable tiles with its top-left corner at
+  // (x, y), 0 if the tile is occupied.
+  int getClearance(int x, int y) const {
+    std::shared_lock guard(lock);
+    return clearance->at(x, y);
+  }
+
+  // Finds a path for an agent covering size x size tiles, positions are the
+  // top-left tile of the agent. Empty if there is none.
+  std::vector<Vec2i> findPath(Workspace &work, const Vec2i &src,
+                              const Vec2i &dest, int size = 1) {
+    begin(work, src, dest, size);
+    resume(work, SIZE_MAX);
+    return work.path;
+  }
+
+  // Starts a search advanced with resume(), replacing the one in progress.
+  // Endpoints in different regions fail without searching.
+  void begin(Workspace &work, const Vec2i &src, const Vec2i &dest,
+             int size = 1) {
+    refresh();
+    std::shared_lock guard(lock);
+    work.src = src;
+    work.dest = dest;
+    work.expanded = 0;
+    work.path.clear();
+    work.status = pathfind::SearchStatus::NotFound;
+    if (!passable.isValid(src) || !passable.isValid(dest) ||
+        !regions->isConnected(src, dest)) {
+      return;
+    }
+
+    // Larger agents search the clearance, the clusters only describe 1x1
+    // agents. Distant goals are searched over clusters, near ones directly.
+    work.status = pathfind::SearchStatus::InProgress;
+    if (size > 1) {
+      if (!clearance->fits(src.x, src.y, size) ||
+          !clearance->fits(dest.x, dest.y, size)) {
+        work.status = pathfind::SearchStatus::NotFound;
+        return;
+      }
+
+      work.kind = Workspace::Kind::Sized;
+      work.agent = &sizedSearch(work, size);
+      work.agent->begin(src, dest);
+    } else if (std::abs(src.x - dest.x) + std::abs(src.y - dest.y) >
+               CLUSTER_SIZE) {
+      work.kind = Workspace::Kind::Hierarchical;
+      hierarchy->begin(src, dest, work.clusters);
+    } else {
+      work.kind = Workspace::Kind::Direct;
+      directSearch(work).begin(src, dest);
+    }
+  }
+
+  // Expands about budget cells of the search in progress. Searches over the
+  // clusters flood whole clusters, overshooting by at most one of them.
+  pathfind::SearchStatus resume(Workspace &work, std::size_t budget) {
+    if (work.status != pathfind::SearchStatus::InProgress) {
+      return work.status;
+    }
+
+    refresh();
+    std::shared_lock guard(lock);
+    switch (work.kind) {
+    case Workspace::Kind::Hierarchical:
+      work.status = hierarchy->resume(budget, work.clusters);
+      work.expanded = work.clusters.getExpanded();
+      if (work.status == pathfind::SearchStatus::Found) {
+        work.path = work.clusters.getPath();
+      }
+
+      break;
+    case Workspace::Kind::Sized:
+      advance(work, *work.agent, budget);
+      break;
+    case Workspace::Kind::Direct:
+      advance(work, directSearch(work), budget);
+      break;
+    }
+
+    return work.status;
+  }
+
+  // Path to the closest position accepted by is_goal(Vec2i), found with one
+  // search. Empty if none can be reached.
+  template <typename Predicate>
+  std::vector<Vec2i> findNearest(Workspace &work, const Vec2i &src,
+                                 Predicate is_goal) {
+    refresh();
+    std::shared_lock guard(lock);
+    if (!passable.isValid(src) || passable.isOccupied(src.x, src.y)) {
+      return {};
+    }
+
+    return directSearch(work).findNearest(src, is_goal);
+  }
+
+  // Path to the closest of the goals, found with one search. Goals in other
+  // regions are dropped before searching.
+  std::vector<Vec2i> findNearest(Workspace &work, const Vec2i &src,
+                                 const std::vector<Vec2i> &goals) {
+    refresh();
+    std::shared_lock guard(lock);
+    if (!passable.isValid(src) || passable.isOccupied(src.x, src.y)) {
+      return {};
+    }
+
+    std::vector<Vec2i> reachable;
+    for (const Vec2i &goal : goals) {
+      if (regions->isConnected(src, goal)) {
+        reachable.push_back(goal);
+      }
+    }
+
+    if (reachable.empty()) {
+      return {};
+    }
+
+    return directSearch(work).findNearest(src, reachable);
+  }
+
+private:
+  pathfind::BitGrid passable;              // Occupied tiles.
+  std::unique_ptr<Regions> regions;        // Connected passable tiles.
+  std::unique_ptr<Landmarks> landmarks;    // Distances for the heuristic.
+  std::unique_ptr<Hierarchy> hierarchy;    // Clusters over passable.
+  std::unique_ptr<Clearance> clearance;    // Room for larger agents.
+  mutable std::shared_mutex lock;          // Held shared while searching.
+  std::atomic<bool> stale = false;         // Tiles opened since landmarks.
+
+  // Rebuilds the landmarks if tiles opened up, distances through them could
+  // overestimate. Blocked tiles only lengthen paths, the distances still
+  // underestimate.
+  void refresh() {
+    if (!stale.load(std::memory_order_acquire)) {
+      return;
+    }
+
+    std::unique_lock guard(lock);
+    if (stale.load(std::memory_order_relaxed)) {
+      landmarks->rebuild();
+      stale.store(false, std::memory_order_release);
+    }
+  }
+
+  // Search for 1x1 agents of the workspace.
+  Search &directSearch(Workspace &work) {
+    if (!work.direct) {
+      work.direct = std::make_unique<Search>(Accessor(passable),
+                                             Heuristic(*landmarks));
+    }
+
+    return *work.direct;
+  }
+
+  // Search over the clearance for agents of the size, distances for 1x1
+  // agents never overestimate so the landmarks still apply.
+  SizedSearch &sizedSearch(Workspace &work, int size) {
+    std::unique_ptr<SizedSearch> &found = work.sized[size];
+    if (!found) {
+      found = std::make_unique<SizedSearch>(
+          pathfind::ClearanceAccessor<Clearance>(*clearance, size),
+          Heuristic(*landmarks));
+    }
+
+    return *found;
+  }
+
+  // Resumes a grid search, recording what it expanded and its path.
+  template <typename S>
+  static void advance(Workspace &work, S &search, std::size_t budget) {
+    work.status = search.resume(budget);
+    work.expanded = search.getExpanded();
+    if (work.status == pathfind::SearchStatus::Found) {
+      work.path = search.getPath();
+    }
+  }
+};
+
+#endif
\ No newline at end of file
@@ -1,170 +1,312 @@
 #ifndef _PATHFIND_ASTAR_HPP
 #define _PATHFIND_ASTAR_HPP
 
+#include "context.hpp"
 #include "grid.hpp"
+#include "heuristic.hpp"
+#include "neighborhood.hpp"
 #include "util.hpp"
 #include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
-#include <queue>
 #include <stdexcept>
-#include <type_traits>
-#include <unordered_map>
 #include <vector>
 
 namespace pathfind {
 
-// Heuristics used to calculate cost / distance differently.
-enum class HeuristicType { Manhattan, Chebyshev, Euclidean };
+// State of a search that can be resumed.
+enum class SearchStatus {
+  InProgress, // Budget ran out before the search finished.
+  Found,      // Path was found.
+  NotFound,   // Every reachable cell was expanded without finding the end.
+  GaveUp,     // Expansion limit was reached.
+};
 
-class HeuristicFunction {
+// A* with the grid access, heuristic and neighborhood supplied as policies.
+// With compile-time policies the entire inner loop is inlined.
+//
+// Accessor:     getWidth(), getHeight() and isOccupied(x, y).
+// Heuristic:    int operator()(Vec2i, Vec2i).
+// Neighborhood: offsets() and resolve(Vec2i &, width, height).
+template <typename Accessor, typename Heuristic = ManhattanHeuristic,
+          typename Neighborhood = FourWay>
+class BasicAStar {
 public:
-  static int Manhattan(Vec2i start, Vec2i end) {
-    return std::abs(start.x - end.x) + std::abs(start.y - end.y);
+  explicit BasicAStar(Accessor grid, Heuristic heuristic = Heuristic(),
+                      Neighborhood neighborhood = Neighborhood())
+      : grid(grid), heuristic(heuristic), neighborhood(neighborhood),
+        width(grid.getWidth()), height(grid.getHeight()) {
+    if (width == 0 || height == 0) {
+      throw std::runtime_error("Invalid dimensions for grid provided.");
+    }
   }
 
-  static int Chebyshev(Vec2i start, Vec2i end) {
-    return std::max(std::abs(start.x - start.y), std::abs(end.y - start.y));
+  int getHeight() const { return height; } // Height of the grid.
+  int getWidth() const { return width; }   // Width of the grid.
+
+  // Amount of cells expanded by the latest search.
+  std::size_t getExpanded() const { return context.getExpanded(); }
+
+  // Finds the path from start to end. Search state is kept between calls, so
+  // repeated searches only allocate the returned path.
+  std::vector<Vec2i> findPath(const Vec2i &start, const Vec2i &end) {
+    begin(start, end);
+    if (resume(SIZE_MAX) == SearchStatus::Found) {
+      return getPath();
+    }
+
+    return {};
   }
 
-  static int Euclidean(Vec2i start, Vec2i end) {
-    return std::sqrt((end.x - start.x) * (end.x - start.x) +
-                     (end.y - start.y) * (end.y - start.y));
+  // Starts a search that is advanced with resume(), replacing any search in
+  // progress. The search gives up after expanding limit cells.
+  void begin(const Vec2i &start, const Vec2i &end,
+             std::size_t limit = SIZE_MAX) {
+    if (!isValid(start) || !isValid(end)) {
+      throw std::runtime_error(
+          "Invalid start or end position for pathfinding.");
+    }
+
+    context.begin(static_cast<std::size_t>(width) * height);
+    origin = index(start);
+    goal = index(end);
+    target = end;
+    cap = limit;
+    status = SearchStatus::InProgress;
+
+    int h = heuristic(start, end);
+    context.visit(origin, 0, SearchContext::NO_PARENT);
+    context.open.push(origin, {h, h});
   }
 
-  // Function that selects the appropriate heuristic based on type.
-  static std::function<int(Vec2i, Vec2i)> getHeuristic(HeuristicType type) {
-    switch (type) {
-    case HeuristicType::Chebyshev:
-      return Chebyshev;
-    case HeuristicType::Euclidean:
-      return Euclidean;
-    default:
-      return Manhattan;
+  // Expands at most budget cells of the search in progress.
+  SearchStatus resume(std::size_t budget) {
+    while (status == SearchStatus::InProgress && budget-- > 0) {
+      expand();
     }
+
+    return status;
   }
-};
 
-struct Node {
-  Vec2i position;
-  Node *parent;
-  int g, h; // Cost to start node, heuristic to end node.
+  // Expands at most budget cells, stopping early once the time runs out.
+  SearchStatus resume(std::size_t budget, std::chrono::microseconds time) {
+    auto deadline = std::chrono::steady_clock::now() + time;
+    while (status == SearchStatus::InProgress && budget > 0) {
+      // Reading the clock every expansion would cost more than expanding.
+      std::size_t slice = std::min<std::size_t>(budget, CLOCK_INTERVAL);
+      budget -= slice;
+      resume(slice);
+      if (std::chrono::steady_clock::now() >= deadline) {
+        break;
+      }
+    }
+
+    return status;
+  }
 
-  Node(Vec2i pos, Node *p = nullptr, int g_cost = 0, int h_cost = 0)
-      : position(pos), parent(p), g(g_cost), h(h_cost) {}
+  // Finds the path to the closest cell accepted by is_goal(Vec2i), in a
+  // single search expanding outwards from the start. Empty if no accepted
+  // cell can be reached.
+  template <typename Predicate>
+  std::vector<Vec2i> findNearest(const Vec2i &start, Predicate is_goal) {
+    if (!isValid(start)) {
+      throw std::runtime_error("Invalid start position for pathfinding.");
+    }
 
-  int f() const { return g + h; } // Total cost.
-};
+    context.begin(static_cast<std::size_t>(width) * height);
+    origin = index(start);
+    cap = SIZE_MAX;
+    context.visit(origin, 0, SearchContext::NO_PARENT);
+    context.open.push(origin, {0, 0});
 
-struct CompareNode {
-  bool operator()(Node *a, Node *b) const { return a->f() > b->f(); }
-};
+    while (!context.open.empty()) {
+      std::uint32_t current = context.open.pop();
+      Vec2i position(current % width, current / width);
+      if (is_goal(position)) {
+        goal = current;
+        target = position;
+        status = SearchStatus::Found;
+        return context.reconstruct(current, width);
+      }
 
-template <Occupiable T> class AStar {
-public:
-  AStar(std::unique_ptr<Grid<T>> grid, bool allow_diagonal = false,
-        bool wrap = false, HeuristicType ht = HeuristicType::Manhattan)
-      : grid(std::move(grid)), wrap(wrap),
-        heuristic(HeuristicFunction::getHeuristic(ht)) {
-    Vec2i dimensions = this->grid->getDimensions();
-    if (dimensions.x == 0 || dimensions.y == 0) {
-      throw std::runtime_error("Invalid dimensions for grid provided.");
+      // Without a single goal there is nothing to estimate towards.
+      context.close(current);
+      relax(current, [](const Vec2i &) { return 0; });
     }
 
-    // Set the diagonal ability.
-    offsets = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}};
-    if (allow_diagonal) {
-      std::vector<Vec2i> ext = {{1, -1}, {1, 1}, {-1, 1}, {-1, -1}};
-      offsets.insert(offsets.end(), ext.begin(), ext.end());
+    status = SearchStatus::NotFound;
+    return {};
+  }
+
+  // Finds the path to the closest of the goals in a single search.
+  std::vector<Vec2i> findNearest(const Vec2i &start,
+                                 const std::vector<Vec2i> &goals) {
+    std::vector<std::uint32_t> cells;
+    for (const Vec2i &goal : goals) {
+      if (isValid(goal)) {
+        cells.push_back(index(goal));
+      }
+    }
+
+    if (cells.empty()) {
+      status = SearchStatus::NotFound;
+      return {};
     }
+
+    std::sort(cells.begin(), cells.end());
+    return findNearest(start, [&](const Vec2i &position) {
+      return std::binary_search(cells.begin(), cells.end(), index(position));
+    });
   }
 
-  int getHeight() const { return height; } // Height of the grid.
-  int getWidth() const { return width; }   // Width of the grid.
+  // State of the latest search.
+  SearchStatus getStatus() const { return status; }
 
-  // Finds the path from start to end.
-  std::vector<Vec2i> findPath(const Vec2i &start, const Vec2i &end) {
-    if (!grid->isValid(start) || !grid->isValid(end)) {
-      throw new std::runtime_error(
-          "Invalid start or end position for pathfinding.");
+  // Path found by the latest search, empty unless it was found.
+  std::vector<Vec2i> getPath() const {
+    if (status != SearchStatus::Found) {
+      return {};
     }
 
-    std::priority_queue<Node *, std::vector<Node *>, CompareNode> open_list;
-    std::unordered_map<Vec2i, std::unique_ptr<Node>> all_nodes;
+    return context.reconstruct(goal, width);
+  }
 
-    all_nodes[start] =
-        std::make_unique<Node>(start, nullptr, 0, heuristic(start, end));
-    open_list.push(all_nodes[start].get());
+private:
+  Accessor grid;             // Grid being processed.
+  Heuristic heuristic;       // Heuristic for distance / cost.
+  Neighborhood neighborhood; // Offsets to get neighboring cells.
+  int width, height;         // Dimensions of the inner grid.
+  SearchContext context;     // Search state reused between searches.
 
-    while (!open_list.empty()) {
-      Node *current = open_list.top();
-      open_list.pop();
+  static constexpr std::size_t CLOCK_INTERVAL = 64; // Expansions per check.
 
-      // Algorithm is complete, it found a path.
-      if (current->position == end) {
-        return reconstructPath(current);
-      }
+  // Search in progress.
+  std::uint32_t origin = 0, goal = 0; // Start and end cells.
+  Vec2i target = {0, 0};              // End position.
+  std::size_t cap = SIZE_MAX;         // Expansions before giving up.
+  SearchStatus status = SearchStatus::NotFound;
 
-      // Explore the neighbors of the current node.
-      for (Vec2i neighbor_pos : getNeighbors(current->position)) {
-        if (is_occupiable_impl<T>::check(
-                grid->at(neighbor_pos.x, neighbor_pos.y))) {
-          continue;
-        }
-
-        // Check if the neighbor has not been visited or a cheaper path is
-        // found.
-        int g_score = current->g + 1;
-        if (!all_nodes.count(neighbor_pos) ||
-            g_score < all_nodes[neighbor_pos]->g) {
-          all_nodes[neighbor_pos] = std::make_unique<Node>(
-              neighbor_pos, current, g_score, heuristic(neighbor_pos, end));
-          open_list.push(all_nodes[neighbor_pos].get());
-        }
-      }
+  // Expands the cheapest open cell.
+  void expand() {
+    if (context.open.empty()) {
+      status = SearchStatus::NotFound;
+      return;
     }
 
-    return {};
+    std::uint32_t current = context.open.pop();
+
+    // Algorithm is complete, it found a path.
+    if (current == goal) {
+      status = SearchStatus::Found;
+      return;
+    } else if (context.getExpanded() >= cap) {
+      status = SearchStatus::GaveUp;
+      return;
+    }
+
+    context.close(current);
+    relax(current, [this](const Vec2i &position) {
+      return heuristic(position, target);
+    });
   }
 
-private:
-  int height, width;             // Dimensions of the inner grid.
-  bool wrap;                     // Allow looping around borders of the grid.
-  std::unique_ptr<Grid<T>> grid; // Grid being processed.
-  std::vector<Vec2i> offsets;    // Offsets to get neighboring cells.
-  std::function<int(Vec2i, Vec2i)> heuristic; // Heuristic for distance / cost.
-
-  // Obtains all neighbors to the position while respecting grid boundaries.
-  std::vector<Vec2i> getNeighbors(const Vec2i &position) {
-    std::vector<Vec2i> neighbors;
-    for (const Vec2i &offset : offsets) {
-      Vec2i neighbor = position + offset;
-
-      if (wrap) {
-        neighbor.x = (neighbor.x + width) % width;
-        neighbor.y = (neighbor.y + height) % height;
-        neighbors.push_back(neighbor);
-      } else if (grid->isValid(neighbor)) {
-        neighbors.push_back(neighbor);
+  // Opens the neighbors of the current node that are reached cheaper through
+  // it, estimating their remaining cost with h(Vec2i).
+  template <typename Estimate>
+  void relax(std::uint32_t current, const Estimate &h) {
+    Vec2i position(current % width, current / width);
+    int g_score = context.g(current) + 1;
+
+    // Explore the neighbors of the current node.
+    for (const Vec2i &offset : neighborhood.offsets()) {
+      Vec2i neighbor_pos = position + offset;
+      if (!neighborhood.resolve(neighbor_pos, width, height)) {
+        continue;
+      }
+
+      // Check if the neighbor has not been visited or a cheaper path is
+      // found.
+      std::uint32_t neighbor = index(neighbor_pos);
+      if (g_score >= context.g(neighbor) ||
+          grid.isOccupied(neighbor_pos.x, neighbor_pos.y)) {
+        continue;
       }
+
+      int estimate = h(neighbor_pos);
+      context.visit(neighbor, g_score, current);
+      context.open.push(neighbor, {g_score + estimate, estimate});
     }
+  }
 
-    return neighbors;
+  // Check if a position is within the bounds of the grid.
+  bool isValid(const Vec2i &position) const {
+    return position.x >= 0 && position.x < width && position.y >= 0 &&
+           position.y < height;
   }
 
-  // Reconstructs the path starting at the current node to the start.
-  std::vector<Vec2i> reconstructPath(Node *current_node) {
-    std::vector<Vec2i> path;
+  // Converts a position into an index for the search context.
+  std::uint32_t index(const Vec2i &position) const {
+    return position.y * width + position.x;
+  }
+};
 
-    while (current_node) {
-      path.push_back(current_node->position);
-      current_node = current_node->parent;
-    }
+// A* configured at runtime, operating on any Grid implementation.
+template <Occupiable T> class AStar {
+public:
+  AStar(std::unique_ptr<Grid<T>> grid, bool allow_diagonal = false,
+        bool wrap = false, HeuristicType ht = HeuristicType::Manhattan)
+      : grid(std::move(grid)),
+        search(GridAccessor<T>(*this->grid), DynamicHeuristic(ht),
+               DynamicNeighborhood(allow_diagonal, wrap)) {}
+
+  int getHeight() const { return search.getHeight(); } // Height of the grid.
+  int getWidth() const { return search.getWidth(); }   // Width of the grid.
+
+  // Amount of cells expanded by the latest search.
+  std::size_t getExpanded() const { return search.getExpanded(); }
+
+  // Finds the path from start to end.
+  std::vector<Vec2i> findPath(const Vec2i &start, const Vec2i &end) {
+    return search.findPath(start, end);
+  }
 
-    std::reverse(path.begin(), path.end());
-    return path;
+  // Starts a search advanced with resume(), see BasicAStar.
+  void begin(const Vec2i &start, const Vec2i &end,
+             std::size_t limit = SIZE_MAX) {
+    search.begin(start, end, limit);
   }
+
+  // Expands at most budget cells of the search in progress.
+  SearchStatus resume(std::size_t budget) { return search.resume(budget); }
+  SearchStatus resume(std::size_t budget, std::chrono::microseconds time) {
+    return search.resume(budget, time);
+  }
+
+  SearchStatus getStatus() const { return search.getStatus(); }
+  std::vector<Vec2i> getPath() const { return search.getPath(); }
+
+  // Finds the path to the closest cell whose data is accepted by is_goal.
+  std::vector<Vec2i>
+  findNearest(const Vec2i &start,
+              const std::function<bool(const T &)> &is_goal) {
+    return search.findNearest(start, [&](const Vec2i &position) {
+      return is_goal(grid->at(position.x, position.y));
+    });
+  }
+
+  // Finds the path to the closest of the goals.
+  std::vector<Vec2i> findNearest(const Vec2i &start,
+                                 const std::vector<Vec2i> &goals) {
+    return search.findNearest(start, goals);
+  }
+
+private:
+  std::unique_ptr<Grid<T>> grid; // Grid being processed.
+  BasicAStar<GridAccessor<T>, DynamicHeuristic, DynamicNeighborhood> search;
 };
 } // namespace pathfind
 
-#endif
\ No newline at end of file
+#endif
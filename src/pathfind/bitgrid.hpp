@@ -0,0 +1,95 @@
+#ifndef _PATHFIND_BIT_GRID_HPP
+#define _PATHFIND_BIT_GRID_HPP
+
+#include "grid.hpp"
+#include "util.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pathfind {
+
+// Passability of a grid packed into one bit per cell, set bits are occupied.
+class BitGrid {
+public:
+  BitGrid() {}
+  BitGrid(int width, int height)
+      : width(width), height(height),
+        words((static_cast<std::size_t>(width) * height + 63) / 64, 0) {}
+
+  int getWidth() const { return width; }   // Width of the grid.
+  int getHeight() const { return height; } // Height of the grid.
+
+  // Checks if a position is within the bounds of the grid.
+  bool isValid(const Vec2i &position) const {
+    return position.x >= 0 && position.x < width && position.y >= 0 &&
+           position.y < height;
+  }
+
+  // Checks if a position is occupied.
+  bool isOccupied(int x, int y) const {
+    std::size_t i = static_cast<std::size_t>(y) * width + x;
+    return (words[i / 64] >> (i % 64)) & 1;
+  }
+
+  // Marks a position as occupied or passable.
+  void set(int x, int y, bool occupied) {
+    std::size_t i = static_cast<std::size_t>(y) * width + x;
+    if (occupied) {
+      words[i / 64] |= std::uint64_t(1) << (i % 64);
+    } else {
+      words[i / 64] &= ~(std::uint64_t(1) << (i % 64));
+    }
+  }
+
+private:
+  int width = 0, height = 0;
+  std::vector<std::uint64_t> words; // Bits in row-major order.
+};
+
+// Grid that reads directly from a BitGrid without copying it. The BitGrid
+// must outlive the view.
+class BitGridView : public Grid<bool> {
+public:
+  explicit BitGridView(const BitGrid &bits) : bits(&bits) {}
+
+  // Checks if a position is occupied.
+  bool isOccupied(int x, int y) const override {
+    return bits->isOccupied(x, y);
+  }
+
+  // Checks if a position provided is within the bounds of the grid.
+  bool isValid(const Vec2i &position) const override {
+    return bits->isValid(position);
+  }
+
+  // Obtains the occupied flag at a specific location within the grid.
+  bool at(int x, int y) const override { return bits->isOccupied(x, y); }
+
+  // Obtains the dimensions of the grid.
+  Vec2i getDimensions() const override {
+    return Vec2i(bits->getWidth(), bits->getHeight());
+  }
+
+private:
+  const BitGrid *bits;
+};
+
+// Grid accessor policy for BasicAStar that reads the bits directly.
+class BitGridAccessor {
+public:
+  explicit BitGridAccessor(const BitGrid &bits) : bits(&bits) {}
+
+  int getWidth() const { return bits->getWidth(); }   // Width of the grid.
+  int getHeight() const { return bits->getHeight(); } // Height of the grid.
+
+  // Checks if a position is occupied.
+  bool isOccupied(int x, int y) const { return bits->isOccupied(x, y); }
+
+private:
+  const BitGrid *bits;
+};
+
+} // namespace pathfind
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef _PATHFIND_CLEARANCE_HPP
+#define _PATHFIND_CLEARANCE_HPP
+
+#include "util.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace pathfind {
+
+// Size of the largest passable square with its top-left corner at each cell,
+// capped at MAX_CLEARANCE. An agent covering an n x n square fits at a cell
+// when the clearance is at least n, a single comparison instead of checking
+// its whole footprint.
+//
+// Accessor: getWidth(), getHeight() and isOccupied(x, y).
+template <typename Accessor> class ClearanceMap {
+public:
+  static constexpr std::uint8_t MAX_CLEARANCE = 16; // Largest agent size.
+
+  explicit ClearanceMap(Accessor grid)
+      : grid(grid), width(grid.getWidth()), height(grid.getHeight()) {
+    if (width == 0 || height == 0) {
+      throw std::runtime_error("Invalid dimensions for grid provided.");
+    }
+
+    values.assign(static_cast<std::size_t>(width) * height, 0);
+    compute(0, 0, width - 1, height - 1);
+  }
+
+  int getHeight() const { return height; } // Height of the grid.
+  int getWidth() const { return width; }   // Width of the grid.
+
+  // Clearance of the cell at (x, y), 0 if occupied.
+  std::uint8_t at(int x, int y) const {
+    return values[static_cast<std::size_t>(y) * width + x];
+  }
+
+  // Checks if an agent of the size fits with its top-left corner at (x, y).
+  bool fits(int x, int y, int size) const { return at(x, y) >= size; }
+
+  // Updates the clearance after the cell at (x, y) changed passability. Only
+  // squares that could contain the cell are recomputed.
+  void update(int x, int y) {
+    compute(std::max(0, x - MAX_CLEARANCE + 1),
+            std::max(0, y - MAX_CLEARANCE + 1), x, y);
+  }
+
+private:
+  Accessor grid;                     // Grid being processed.
+  int width, height;                 // Dimensions of the inner grid.
+  std::vector<std::uint8_t> values;  // Clearance of every cell.
+
+  // Recomputes the area bottom-right first, each cell grows from the
+  // clearance of the cells right, below and diagonally below it.
+  void compute(int left, int top, int right, int bottom) {
+    for (int y = bottom; y >= top; y--) {
+      for (int x = right; x >= left; x--) {
+        std::uint8_t value = 0;
+        if (!grid.isOccupied(x, y)) {
+          std::uint8_t smallest =
+              x + 1 < width && y + 1 < height
+                  ? std::min({at(x + 1, y), at(x, y + 1), at(x + 1, y + 1)})
+                  : 0;
+          value = std::min<std::uint8_t>(smallest + 1, MAX_CLEARANCE);
+        }
+
+        values[static_cast<std::size_t>(y) * width + x] = value;
+      }
+    }
+  }
+};
+
+// Grid accessor policy that treats cells an agent of a fixed size cannot fit
+// at as occupied, letting any search path larger agents.
+template <typename Clearance> class ClearanceAccessor {
+public:
+  ClearanceAccessor(const Clearance &clearance, int size)
+      : clearance(&clearance), size(size) {}
+
+  int getWidth() const { return clearance->getWidth(); }   // Width of grid.
+  int getHeight() const { return clearance->getHeight(); } // Height of grid.
+
+  // Checks if the agent cannot fit at a position.
+  bool isOccupied(int x, int y) const { return !clearance->fits(x, y, size); }
+
+private:
+  const Clearance *clearance;
+  int size; // Width / height of the agent.
+};
+
+} // namespace pathfind
+
+#endif
\ No newline at end of file
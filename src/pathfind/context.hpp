@@ -0,0 +1,102 @@
+#ifndef _PATHFIND_CONTEXT_HPP
+#define _PATHFIND_CONTEXT_HPP
+
+#include "heap.hpp"
+#include "util.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace pathfind {
+
+// Per-cell search state stored in flat arrays and reused between searches.
+// Instead of clearing every array, each search gets a new generation and a
+// cell's data only counts if it was stamped during the current generation.
+class SearchContext {
+public:
+  static constexpr std::uint32_t NO_PARENT = UINT32_MAX;
+  static constexpr int UNREACHED = std::numeric_limits<int>::max();
+
+  // Ordering for the open list, lowest f cost first, ties broken by the
+  // lowest heuristic (closest to the goal).
+  using Key = std::pair<int, int>;
+
+  IndexedHeap<Key> open; // Cells waiting to be expanded.
+
+  // Starts a new search over a grid with the amount of cells.
+  void begin(std::size_t cells) {
+    if (stamps.size() != cells) {
+      stamps.assign(cells, 0);
+      closed.assign(cells, 0);
+      costs.resize(cells);
+      parents.resize(cells);
+      generation = 0;
+    }
+
+    // Stamps from the previous cycle would be mistaken as current.
+    if (++generation == 0) {
+      std::fill(stamps.begin(), stamps.end(), 0);
+      std::fill(closed.begin(), closed.end(), 0);
+      generation = 1;
+    }
+
+    open.reset(cells);
+    expanded = 0;
+  }
+
+  // Cost from the start to the cell, or UNREACHED.
+  int g(std::uint32_t cell) const {
+    return stamps[cell] == generation ? costs[cell] : UNREACHED;
+  }
+
+  // Parent of the cell on the cheapest known path, or NO_PARENT.
+  std::uint32_t parent(std::uint32_t cell) const {
+    return stamps[cell] == generation ? parents[cell] : NO_PARENT;
+  }
+
+  // Records a cheaper path to the cell.
+  void visit(std::uint32_t cell, int g, std::uint32_t parent) {
+    stamps[cell] = generation;
+    costs[cell] = g;
+    parents[cell] = parent;
+  }
+
+  // Checks if the cell has already been expanded.
+  bool isClosed(std::uint32_t cell) const { return closed[cell] == generation; }
+
+  // Marks the cell as expanded.
+  void close(std::uint32_t cell) {
+    closed[cell] = generation;
+    expanded++;
+  }
+
+  // Amount of cells expanded by the current search.
+  std::size_t getExpanded() const { return expanded; }
+
+  // Follows parents from the cell back to the start, returning the path in
+  // order from start to the cell.
+  std::vector<Vec2i> reconstruct(std::uint32_t cell, int width) const {
+    std::vector<Vec2i> path;
+    for (std::uint32_t at = cell; at != NO_PARENT; at = parent(at)) {
+      path.emplace_back(at % width, at / width);
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+  }
+
+private:
+  std::vector<std::uint32_t> stamps; // Generation g / parent were set.
+  std::vector<std::uint32_t> closed; // Generation the cell was expanded.
+  std::vector<int> costs;            // Cost from the start.
+  std::vector<std::uint32_t> parents;
+  std::uint32_t generation = 0;
+  std::size_t expanded = 0;
+};
+
+} // namespace pathfind
+
+#endif
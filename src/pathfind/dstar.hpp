@@ -0,0 +1,239 @@
+#ifndef _PATHFIND_DSTAR_HPP
+#define _PATHFIND_DSTAR_HPP
+
+#include "heap.hpp"
+#include "heuristic.hpp"
+#include "neighborhood.hpp"
+#include "util.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace pathfind {
+
+// Incremental planner (D* Lite) for an agent heading to a fixed goal. The
+// search runs backwards from the goal and its state is kept, so after cells
+// change passability only the affected part of the search is repaired
+// instead of planning from scratch. Moving the start as the agent walks is
+// free.
+//
+// Accessor:     getWidth(), getHeight() and isOccupied(x, y).
+// Heuristic:    int operator()(Vec2i, Vec2i).
+// Neighborhood: offsets() and resolve(Vec2i &, width, height).
+template <typename Accessor, typename Heuristic = ManhattanHeuristic,
+          typename Neighborhood = FourWay>
+class DStarLite {
+public:
+  static constexpr int UNREACHED = std::numeric_limits<int>::max();
+
+  DStarLite(Accessor grid, const Vec2i &start, const Vec2i &goal,
+            Heuristic heuristic = Heuristic(),
+            Neighborhood neighborhood = Neighborhood())
+      : grid(grid), heuristic(heuristic), neighborhood(neighborhood),
+        width(grid.getWidth()), height(grid.getHeight()), start(start),
+        last(start), goal(goal) {
+    if (width == 0 || height == 0) {
+      throw std::runtime_error("Invalid dimensions for grid provided.");
+    } else if (!isValid(start) || !isValid(goal)) {
+      throw std::runtime_error(
+          "Invalid start or end position for pathfinding.");
+    }
+
+    std::size_t cells = static_cast<std::size_t>(width) * height;
+    g.assign(cells, UNREACHED);
+    rhs.assign(cells, UNREACHED);
+    open.reset(cells);
+
+    std::uint32_t target = index(goal);
+    rhs[target] = 0;
+    open.push(target, {heuristic(start, goal), 0});
+  }
+
+  int getHeight() const { return height; } // Height of the grid.
+  int getWidth() const { return width; }   // Width of the grid.
+  const Vec2i &getStart() const { return start; }
+  const Vec2i &getGoal() const { return goal; }
+
+  // Amount of cells expanded by the latest repair.
+  std::size_t getExpanded() const { return expanded; }
+
+  // Moves the start of the search, used as the agent walks along the path.
+  void move(const Vec2i &position) {
+    if (!isValid(position)) {
+      throw std::runtime_error("Invalid start position for pathfinding.");
+    }
+
+    start = position;
+  }
+
+  // Notifies the planner that the cell at (x, y) changed passability. The
+  // search is repaired by the next call to findPath.
+  void update(int x, int y) {
+    if (!isValid(Vec2i(x, y))) {
+      throw std::out_of_range("Index out of bounds for planner.");
+    }
+
+    changed.push_back(index(Vec2i(x, y)));
+  }
+
+  // Repairs the search if needed and returns the path from the start to the
+  // goal, empty if the goal cannot be reached.
+  std::vector<Vec2i> findPath() {
+    // Queued keys were made with the old start, offset them instead of
+    // rebuilding the queue.
+    if (start != last) {
+      offset += heuristic(last, start);
+      last = start;
+    }
+
+    // Edges into and out of a changed cell changed cost.
+    for (std::uint32_t cell : changed) {
+      refresh(cell);
+      forEachNeighbor(cell, [this](std::uint32_t next) { refresh(next); });
+    }
+
+    changed.clear();
+    repair();
+    return walk();
+  }
+
+private:
+  using Key = std::pair<int, int>;
+
+  Accessor grid;             // Grid being processed.
+  Heuristic heuristic;       // Heuristic for distance / cost.
+  Neighborhood neighborhood; // Offsets to get neighboring cells.
+  int width, height;         // Dimensions of the inner grid.
+  Vec2i start, last, goal;   // Current start, start at the last repair, goal.
+  int offset = 0;            // Added to keys as the start moves (k_m).
+
+  std::vector<int> g;   // Cost to the goal as of the last expansion.
+  std::vector<int> rhs; // Cost to the goal through the best neighbor.
+  IndexedHeap<Key> open;               // Inconsistent cells.
+  std::vector<std::uint32_t> changed;  // Cells changed since the repair.
+  std::size_t expanded = 0;
+
+  bool isValid(const Vec2i &position) const {
+    return position.x >= 0 && position.x < width && position.y >= 0 &&
+           position.y < height;
+  }
+
+  std::uint32_t index(const Vec2i &position) const {
+    return position.y * width + position.x;
+  }
+
+  Vec2i positionOf(std::uint32_t cell) const {
+    return Vec2i(cell % width, cell / width);
+  }
+
+  bool occupied(std::uint32_t cell) const {
+    return grid.isOccupied(cell % width, cell / width);
+  }
+
+  template <typename Fn>
+  void forEachNeighbor(std::uint32_t cell, Fn &&fn) const {
+    Vec2i position = positionOf(cell);
+    for (const Vec2i &offset : neighborhood.offsets()) {
+      Vec2i neighbor = position + offset;
+      if (neighborhood.resolve(neighbor, width, height)) {
+        fn(index(neighbor));
+      }
+    }
+  }
+
+  Key keyOf(std::uint32_t cell) const {
+    int best = std::min(g[cell], rhs[cell]);
+    if (best == UNREACHED) {
+      return {UNREACHED, UNREACHED};
+    }
+
+    return {best + heuristic(start, positionOf(cell)) + offset, best};
+  }
+
+  // Recomputes the cost through the best neighbor and queues the cell if it
+  // became inconsistent. Moving into or out of occupied cells is impossible.
+  void refresh(std::uint32_t cell) {
+    if (cell != index(goal)) {
+      int best = UNREACHED;
+      if (!occupied(cell)) {
+        forEachNeighbor(cell, [&](std::uint32_t next) {
+          if (g[next] != UNREACHED && !occupied(next)) {
+            best = std::min(best, g[next] + 1);
+          }
+        });
+      }
+
+      rhs[cell] = best;
+    }
+
+    if (g[cell] != rhs[cell]) {
+      open.push(cell, keyOf(cell));
+    } else if (open.contains(cell)) {
+      open.remove(cell);
+    }
+  }
+
+  // Expands inconsistent cells until the start is consistent and no queued
+  // cell could still lower its cost.
+  void repair() {
+    expanded = 0;
+    std::uint32_t origin = index(start);
+    while (!open.empty() &&
+           (open.topKey() < keyOf(origin) || rhs[origin] != g[origin])) {
+      std::uint32_t current = open.top();
+      Key previous = open.topKey(), key = keyOf(current);
+      expanded++;
+
+      if (previous < key) {
+        open.push(current, key);
+      } else if (g[current] > rhs[current]) {
+        // Cost lowered, neighbors may now go through this cell.
+        g[current] = rhs[current];
+        open.remove(current);
+        forEachNeighbor(current, [this](std::uint32_t next) { refresh(next); });
+      } else {
+        // Cost raised, everything that relied on this cell is recomputed.
+        g[current] = UNREACHED;
+        refresh(current);
+        forEachNeighbor(current, [this](std::uint32_t next) { refresh(next); });
+      }
+    }
+  }
+
+  // Follows the cheapest neighbors from the start down to the goal.
+  std::vector<Vec2i> walk() const {
+    std::uint32_t at = index(start), target = index(goal);
+    if (rhs[at] == UNREACHED || occupied(at)) {
+      return {};
+    }
+
+    std::vector<Vec2i> path = {start};
+    while (at != target && path.size() <= g.size()) {
+      std::uint32_t best = at;
+      int cost = UNREACHED;
+      forEachNeighbor(at, [&](std::uint32_t next) {
+        if (g[next] < cost && !occupied(next)) {
+          best = next;
+          cost = g[next];
+        }
+      });
+
+      if (best == at) {
+        return {};
+      }
+
+      at = best;
+      path.push_back(positionOf(at));
+    }
+
+    return at == target ? path : std::vector<Vec2i>();
+  }
+};
+
+} // namespace pathfind
+
+#endif
\ No newline at end of file
@@ -0,0 +1,125 @@
+#ifndef _PATHFIND_FLOW_FIELD_HPP
+#define _PATHFIND_FLOW_FIELD_HPP
+
+#include "neighborhood.hpp"
+#include "util.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace pathfind {
+
+// Distance and direction towards the nearest of a set of goals for every cell
+// of a grid (a Dijkstra map). Built with one breadth-first search from all of
+// the goals, afterwards any amount of agents can follow it in O(1) per step.
+//
+// Accessor: getWidth(), getHeight() and isOccupied(x, y).
+template <typename Accessor, typename Neighborhood = FourWay> class FlowField {
+public:
+  static constexpr int UNREACHED = std::numeric_limits<int>::max();
+  static constexpr std::uint8_t NONE = UINT8_MAX; // No direction to move.
+
+  FlowField(Accessor grid, const std::vector<Vec2i> &goals)
+      : width(grid.getWidth()), height(grid.getHeight()), goals(goals) {
+    if (width == 0 || height == 0) {
+      throw std::runtime_error("Invalid dimensions for grid provided.");
+    }
+
+    std::size_t cells = static_cast<std::size_t>(width) * height;
+    distances.assign(cells, UNREACHED);
+    directions.assign(cells, NONE);
+    build(grid);
+  }
+
+  int getHeight() const { return height; } // Height of the grid.
+  int getWidth() const { return width; }   // Width of the grid.
+
+  // Goals the field leads to.
+  const std::vector<Vec2i> &getGoals() const { return goals; }
+
+  // Steps from the position to the nearest goal, or UNREACHED.
+  int distance(const Vec2i &position) const {
+    return isValid(position) ? distances[index(position)] : UNREACHED;
+  }
+
+  // Checks if a goal can be reached from the position.
+  bool isReachable(const Vec2i &position) const {
+    return distance(position) != UNREACHED;
+  }
+
+  // Next cell to move to from the position, none if the position is a goal
+  // or no goal can be reached.
+  std::optional<Vec2i> next(const Vec2i &position) const {
+    if (!isValid(position)) {
+      return std::nullopt;
+    }
+
+    std::uint8_t direction = directions[index(position)];
+    if (direction == NONE) {
+      return std::nullopt;
+    }
+
+    Vec2i step = position + Neighborhood::OFFSETS[direction];
+    neighborhood.resolve(step, width, height);
+    return step;
+  }
+
+private:
+  int width, height;                    // Dimensions of the inner grid.
+  std::vector<Vec2i> goals;             // Cells the field leads to.
+  std::vector<int> distances;           // Steps to the nearest goal.
+  std::vector<std::uint8_t> directions; // Offset towards the nearest goal.
+  Neighborhood neighborhood;            // Obtains neighbors of cells.
+
+  bool isValid(const Vec2i &position) const {
+    return position.x >= 0 && position.x < width && position.y >= 0 &&
+           position.y < height;
+  }
+
+  std::size_t index(const Vec2i &position) const {
+    return static_cast<std::size_t>(position.y) * width + position.x;
+  }
+
+  // Index of the offset pointing the opposite way, cardinal and diagonal
+  // offsets are each listed clockwise.
+  static std::uint8_t opposite(std::size_t direction) {
+    return direction < 4 ? (direction + 2) % 4 : 4 + (direction - 2) % 4;
+  }
+
+  // Floods outwards from every goal at once, each cell points back towards
+  // the cell that reached it first.
+  void build(const Accessor &grid) {
+    std::vector<Vec2i> frontier;
+    for (const Vec2i &goal : goals) {
+      if (isValid(goal) && !grid.isOccupied(goal.x, goal.y) &&
+          distances[index(goal)] == UNREACHED) {
+        distances[index(goal)] = 0;
+        frontier.push_back(goal);
+      }
+    }
+
+    for (std::size_t head = 0; head < frontier.size(); head++) {
+      Vec2i current = frontier[head];
+      int steps = distances[index(current)] + 1;
+      for (std::size_t i = 0; i < Neighborhood::COUNT; i++) {
+        Vec2i neighbor = current + Neighborhood::OFFSETS[i];
+        if (!neighborhood.resolve(neighbor, width, height) ||
+            distances[index(neighbor)] != UNREACHED ||
+            grid.isOccupied(neighbor.x, neighbor.y)) {
+          continue;
+        }
+
+        distances[index(neighbor)] = steps;
+        directions[index(neighbor)] = opposite(i);
+        frontier.push_back(neighbor);
+      }
+    }
+  }
+};
+
+} // namespace pathfind
+
+#endif
\ No newline at end of file
@@ -27,6 +27,11 @@ template <typename T> struct is_occupiable_impl<std::shared_ptr<T>> {
   static bool check(const std::shared_ptr<T> &t) { return t->isOccupied(); }
 };
 
+// Specialization for plain flags, where true marks the cell as occupied.
+template <> struct is_occupiable_impl<bool> {
+  static bool check(const bool &t) { return t; }
+};
+
 template <typename T>
 concept Occupiable = requires(T t) {
   { is_occupiable_impl<T>::check(t) } -> std::convertible_to<bool>;
@@ -99,6 +104,25 @@ public:
     return Vec2i(width, grid.size() / width);
   }
 };
+
+// Grid accessor policy for BasicAStar that reads through the Grid interface.
+template <Occupiable T> class GridAccessor {
+public:
+  explicit GridAccessor(const Grid<T> &grid)
+      : grid(&grid), dimensions(grid.getDimensions()) {}
+
+  int getWidth() const { return dimensions.x; }  // Width of the grid.
+  int getHeight() const { return dimensions.y; } // Height of the grid.
+
+  // Checks if a position is occupied.
+  bool isOccupied(int x, int y) const {
+    return is_occupiable_impl<T>::check(grid->at(x, y));
+  }
+
+private:
+  const Grid<T> *grid;
+  Vec2i dimensions;
+};
 } // namespace pathfind
 
 #endif
\ No newline at end of file
@@ -0,0 +1,156 @@
+#ifndef _PATHFIND_HEAP_HPP
+#define _PATHFIND_HEAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pathfind {
+
+// Min-heap of cell indices ordered by a key. The position of every cell is
+// tracked so its key can be changed in place (decrease-key) instead of pushing
+// duplicates. Each node has D children to keep the tree shallow.
+template <typename Key, std::size_t D = 4> class IndexedHeap {
+public:
+  // Prepares the heap for cells in the range [0, cells).
+  void reset(std::size_t cells) {
+    clear();
+    if (position.size() < cells) {
+      position.resize(cells, NONE);
+    }
+  }
+
+  // Removes all cells, only touching the cells currently queued.
+  void clear() {
+    for (const Node &node : nodes) {
+      position[node.cell] = NONE;
+    }
+
+    nodes.clear();
+  }
+
+  bool empty() const { return nodes.empty(); }
+  std::size_t size() const { return nodes.size(); }
+
+  // Checks if the cell is queued.
+  bool contains(std::uint32_t cell) const {
+    return cell < position.size() && position[cell] != NONE;
+  }
+
+  // Queues a cell, or moves it if already queued with a different key.
+  void push(std::uint32_t cell, const Key &key) {
+    if (contains(cell)) {
+      std::size_t index = position[cell];
+      nodes[index].key = key;
+      siftDown(siftUp(index));
+      return;
+    }
+
+    nodes.push_back({key, cell});
+    position[cell] = nodes.size() - 1;
+    siftUp(nodes.size() - 1);
+  }
+
+  // Cell with the lowest key and its key.
+  std::uint32_t top() const { return nodes.front().cell; }
+  const Key &topKey() const { return nodes.front().key; }
+
+  // Key of a queued cell.
+  const Key &keyOf(std::uint32_t cell) const {
+    return nodes[position[cell]].key;
+  }
+
+  // Removes and returns the cell with the lowest key.
+  std::uint32_t pop() {
+    std::uint32_t cell = nodes.front().cell;
+    removeAt(0);
+    return cell;
+  }
+
+  // Removes a cell if it is queued.
+  void remove(std::uint32_t cell) {
+    if (contains(cell)) {
+      removeAt(position[cell]);
+    }
+  }
+
+private:
+  static constexpr std::uint32_t NONE = UINT32_MAX;
+
+  struct Node {
+    Key key;
+    std::uint32_t cell;
+  };
+
+  std::vector<Node> nodes;             // Heap ordered nodes.
+  std::vector<std::uint32_t> position; // Index of each cell within nodes.
+
+  void removeAt(std::size_t index) {
+    position[nodes[index].cell] = NONE;
+    if (index + 1 != nodes.size()) {
+      nodes[index] = nodes.back();
+      position[nodes[index].cell] = index;
+      nodes.pop_back();
+      siftDown(siftUp(index));
+    } else {
+      nodes.pop_back();
+    }
+  }
+
+  // Moves a node towards the root, returning its final index.
+  std::size_t siftUp(std::size_t index) {
+    Node node = nodes[index];
+    while (index > 0) {
+      std::size_t parent = (index - 1) / D;
+      if (!(node.key < nodes[parent].key)) {
+        break;
+      }
+
+      place(index, nodes[parent]);
+      index = parent;
+    }
+
+    place(index, node);
+    return index;
+  }
+
+  // Moves a node towards the leaves, returning its final index.
+  std::size_t siftDown(std::size_t index) {
+    Node node = nodes[index];
+    while (true) {
+      std::size_t first = index * D + 1;
+      if (first >= nodes.size()) {
+        break;
+      }
+
+      // Find the smallest child.
+      std::size_t best = first;
+      std::size_t last = std::min(first + D, nodes.size());
+      for (std::size_t child = first + 1; child < last; child++) {
+        if (nodes[child].key < nodes[best].key) {
+          best = child;
+        }
+      }
+
+      if (!(nodes[best].key < node.key)) {
+        break;
+      }
+
+      place(index, nodes[best]);
+      index = best;
+    }
+
+    place(index, node);
+    return index;
+  }
+
+  void place(std::size_t index, const Node &node) {
+    nodes[index] = node;
+    position[node.cell] = index;
+  }
+};
+
+} // namespace pathfind
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef _PATHFIND_HEURISTIC_HPP
+#define _PATHFIND_HEURISTIC_HPP
+
+#include "util.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+namespace pathfind {
+
+// Heuristics used to calculate cost / distance differently.
+enum class HeuristicType { Manhattan, Chebyshev, Euclidean };
+
+class HeuristicFunction {
+public:
+  static int Manhattan(Vec2i start, Vec2i end) {
+    return std::abs(start.x - end.x) + std::abs(start.y - end.y);
+  }
+
+  static int Chebyshev(Vec2i start, Vec2i end) {
+    return std::max(std::abs(end.x - start.x), std::abs(end.y - start.y));
+  }
+
+  static int Euclidean(Vec2i start, Vec2i end) {
+    return std::sqrt((end.x - start.x) * (end.x - start.x) +
+                     (end.y - start.y) * (end.y - start.y));
+  }
+
+  // Function that selects the appropriate heuristic based on type.
+  static std::function<int(Vec2i, Vec2i)> getHeuristic(HeuristicType type) {
+    switch (type) {
+    case HeuristicType::Chebyshev:
+      return Chebyshev;
+    case HeuristicType::Euclidean:
+      return Euclidean;
+    default:
+      return Manhattan;
+    }
+  }
+};
+
+// Heuristic policies for BasicAStar, resolved at compile time so the calls
+// are inlined into the search loop.
+struct ManhattanHeuristic {
+  int operator()(const Vec2i &start, const Vec2i &end) const {
+    return HeuristicFunction::Manhattan(start, end);
+  }
+};
+
+struct ChebyshevHeuristic {
+  int operator()(const Vec2i &start, const Vec2i &end) const {
+    return HeuristicFunction::Chebyshev(start, end);
+  }
+};
+
+struct EuclideanHeuristic {
+  int operator()(const Vec2i &start, const Vec2i &end) const {
+    return HeuristicFunction::Euclidean(start, end);
+  }
+};
+
+// Heuristic selected at runtime.
+class DynamicHeuristic {
+public:
+  explicit DynamicHeuristic(HeuristicType type)
+      : function(HeuristicFunction::getHeuristic(type)) {}
+
+  int operator()(const Vec2i &start, const Vec2i &end) const {
+    return function(start, end);
+  }
+
+private:
+  std::function<int(Vec2i, Vec2i)> function;
+};
+
+} // namespace pathfind
+
+#endif
@@ -0,0 +1,565 @@
+#ifndef _PATHFIND_HPA_HPP
+#define _PATHFIND_HPA_HPP
+
+#include "astar.hpp"
+#include "context.hpp"
+#include "heuristic.hpp"
+#include "neighborhood.hpp"
+#include "util.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+namespace pathfind {
+
+// Hierarchical pathfinding (HPA*) over a 4-connected grid. The grid is split
+// into fixed size clusters, entrances are placed along the borders between
+// neighboring clusters and the distances between entrances of the same
+// cluster are cached. Searches run over the entrances and only the segments
+// of the chosen route are refined into cells, giving near-optimal paths.
+//
+// Accessor:  getWidth(), getHeight() and isOccupied(x, y).
+// Heuristic: int operator()(Vec2i, Vec2i), guides the search over entrances.
+template <typename Accessor, typename Heuristic = ManhattanHeuristic>
+class HierarchicalSearch {
+  static constexpr int MAX_NARROW = 5; // Longest entrance with one node.
+
+public:
+  // Search state of a query. Queries only read the clusters, so threads
+  // with their own scratch can search at the same time.
+  class Scratch {
+  public:
+    // Entrances and cells expanded by the latest query.
+    std::size_t getExpanded() const { return search.getExpanded() + flooded; }
+
+    // State of the latest query.
+    SearchStatus getStatus() const { return status; }
+
+    // Path found by the latest query, empty until it is found.
+    const std::vector<Vec2i> &getPath() const { return path; }
+
+  private:
+    friend class HierarchicalSearch;
+
+    // Steps of a query advanced with resume().
+    enum class Phase { Goal, Start, Route, Refine };
+
+    SearchContext search;                // Search over the entrances.
+    std::vector<int> steps;              // Local search distances.
+    std::vector<std::uint32_t> frontier; // Queue for local searches.
+    std::size_t flooded = 0;             // Cells reached by local searches.
+
+    Phase phase = Phase::Goal;
+    SearchStatus status = SearchStatus::NotFound;
+    std::uint64_t version = 0;            // Latest rebuild when begun.
+    Vec2i start{0, 0}, end{0, 0};         // Endpoints of the query.
+    std::uint32_t origin = 0, target = 0; // Cells of the endpoints.
+    std::size_t first = 0, last = 0;      // Clusters of the endpoints.
+    std::vector<int> to_goal;    // Entrances of the last cluster to the end.
+    std::vector<int> from_start; // Start to entrances of the first cluster.
+    int direct = 0;              // Start to end when sharing a cluster.
+    std::vector<Vec2i> route;    // Waypoints, once routed.
+    std::size_t segment = 0;     // Waypoint the next refinement ends at.
+    std::vector<Vec2i> path;     // Refined segments.
+  };
+
+  HierarchicalSearch(Accessor grid, int cluster_size,
+                     Heuristic heuristic = Heuristic())
+      : grid(grid), heuristic(heuristic), width(grid.getWidth()),
+        height(grid.getHeight()), size(cluster_size) {
+    if (width == 0 || height == 0 || size <= 0) {
+      throw std::runtime_error("Invalid dimensions for grid provided.");
+    }
+
+    columns = (width + size - 1) / size;
+    rows = (height + size - 1) / size;
+    clusters.resize(columns * rows);
+    for (int cy = 0; cy < rows; cy++) {
+      for (int cx = 0; cx < columns; cx++) {
+        Cluster &cluster = clusters[cy * columns + cx];
+        cluster.x = cx * size;
+        cluster.y = cy * size;
+        cluster.width = std::min(size, width - cluster.x);
+        cluster.height = std::min(size, height - cluster.y);
+      }
+    }
+
+    rebuild();
+  }
+
+  int getHeight() const { return height; }     // Height of the grid.
+  int getWidth() const { return width; }       // Width of the grid.
+  int getClusterSize() const { return size; }  // Width / height of clusters.
+
+  // Entrances and cells expanded by the latest query.
+  std::size_t getExpanded() const { return scratch.getExpanded(); }
+
+  // Rebuilds the entrances and distances of every cluster.
+  void rebuild() {
+    for (std::size_t i = 0; i < clusters.size(); i++) {
+      refresh(i);
+    }
+  }
+
+  // Rebuilds the cluster containing the position (x, y) after its tiles
+  // changed. Neighbors share entrances with it so they are rebuilt as well.
+  void rebuild(int x, int y) {
+    int cx = x / size, cy = y / size;
+    refresh(cy * columns + cx);
+    for (const Vec2i &offset : CARDINAL_OFFSETS) {
+      int nx = cx + offset.x, ny = cy + offset.y;
+      if (nx >= 0 && nx < columns && ny >= 0 && ny < rows) {
+        refresh(ny * columns + nx);
+      }
+    }
+  }
+
+  // Finds a path from start to end, including every cell along the way.
+  std::vector<Vec2i> findPath(const Vec2i &start, const Vec2i &end) {
+    return findPath(start, end, scratch);
+  }
+
+  std::vector<Vec2i> findPath(const Vec2i &start, const Vec2i &end,
+                              Scratch &state) const {
+    begin(start, end, state);
+    if (resume(SIZE_MAX, state) == SearchStatus::Found) {
+      return state.path;
+    }
+
+    return {};
+  }
+
+  // Finds the waypoints from start to end without refining them, each pair
+  // of consecutive waypoints is either adjacent or within the same cluster.
+  // Segments can then be refined as they are reached.
+  std::vector<Vec2i> findRoute(const Vec2i &start, const Vec2i &end) {
+    return findRoute(start, end, scratch);
+  }
+
+  std::vector<Vec2i> findRoute(const Vec2i &start, const Vec2i &end,
+                               Scratch &state) const {
+    begin(start, end, state);
+    while (state.status == SearchStatus::InProgress &&
+           state.phase != Scratch::Phase::Refine) {
+      step(state);
+    }
+
+    return state.route;
+  }
+
+  // Starts a query advanced with resume(), replacing the one in progress.
+  void begin(const Vec2i &start, const Vec2i &end, Scratch &state) const {
+    if (!isValid(start) || !isValid(end)) {
+      throw std::runtime_error(
+          "Invalid start or end position for pathfinding.");
+    }
+
+    state.search.begin(static_cast<std::size_t>(width) * height);
+    state.flooded = 0;
+    state.version = version;
+    state.start = start;
+    state.end = end;
+    state.route.clear();
+    state.path.clear();
+    state.status = SearchStatus::NotFound;
+    if (grid.isOccupied(start.x, start.y) || grid.isOccupied(end.x, end.y)) {
+      return;
+    } else if (start == end) {
+      state.route = {start};
+      state.path = {start};
+      state.status = SearchStatus::Found;
+      return;
+    }
+
+    state.origin = index(start);
+    state.target = index(end);
+    state.first = clusterOf(state.origin);
+    state.last = clusterOf(state.target);
+    state.phase = Scratch::Phase::Goal;
+    state.status = SearchStatus::InProgress;
+  }
+
+  // Advances the query by about budget entrances and cells. Clusters are
+  // flooded whole, so a call overshoots by at most one cluster.
+  SearchStatus resume(std::size_t budget, Scratch &state) const {
+    std::size_t before = state.getExpanded();
+    while (state.status == SearchStatus::InProgress) {
+      std::size_t spent = state.getExpanded() - before;
+      if (budget == 0 || (spent > 0 && spent + upcoming(state) > budget)) {
+        break;
+      }
+
+      step(state);
+    }
+
+    return state.status;
+  }
+
+  // Appends the cells after a waypoint up to and including the next one.
+  void refine(const Vec2i &from, const Vec2i &to, std::vector<Vec2i> &path) {
+    refine(from, to, path, scratch);
+  }
+
+  void refine(const Vec2i &from, const Vec2i &to, std::vector<Vec2i> &path,
+              Scratch &state) const {
+    std::uint32_t source = index(from), target = index(to);
+    if (distance(source, target) == 1) {
+      path.push_back(to);
+      return;
+    }
+
+    // Walk back from the end of the segment along decreasing distances.
+    const Cluster &cluster = clusters[clusterOf(source)];
+    flood(source, cluster, state, target);
+    std::size_t end = path.size();
+    for (std::uint32_t at = target; at != source;) {
+      path.emplace_back(at % width, at / width);
+      for (const Vec2i &offset : CARDINAL_OFFSETS) {
+        int x = at % width + offset.x, y = at / width + offset.y;
+        if (x >= cluster.x && x < cluster.x + cluster.width &&
+            y >= cluster.y && y < cluster.y + cluster.height &&
+            reached(y * width + x, cluster, state) ==
+                reached(at, cluster, state) - 1) {
+          at = y * width + x;
+          break;
+        }
+      }
+    }
+
+    std::reverse(path.begin() + end, path.end());
+  }
+
+private:
+  // Fixed area of the grid and its entrances.
+  struct Cluster {
+    int x = 0, y = 0, width = 0, height = 0; // Bounds in cells.
+    std::vector<std::uint32_t> nodes;        // Entrance cells.
+    std::vector<std::vector<std::uint32_t>> links; // Cells across borders.
+    std::vector<int> distances; // Between entrances, nodes x nodes.
+    std::uint64_t version = 0;  // Stamp of the latest rebuild.
+  };
+
+  Accessor grid;                 // Grid being processed.
+  Heuristic heuristic;           // Estimate between entrances and the goal.
+  int width, height;             // Dimensions of the inner grid.
+  int size;                      // Width / height of a cluster.
+  int columns = 0, rows = 0;     // Amount of clusters per axis.
+  std::vector<Cluster> clusters; // Row-major clusters.
+  std::uint64_t version = 0;     // Stamp of the latest cluster rebuild.
+  Scratch scratch;               // State for building and own queries.
+
+  bool isValid(const Vec2i &position) const {
+    return position.x >= 0 && position.x < width && position.y >= 0 &&
+           position.y < height;
+  }
+
+  bool walkable(int x, int y) const {
+    return x >= 0 && x < width && y >= 0 && y < height &&
+           !grid.isOccupied(x, y);
+  }
+
+  std::uint32_t index(const Vec2i &position) const {
+    return position.y * width + position.x;
+  }
+
+  std::size_t clusterOf(std::uint32_t cell) const {
+    return (cell / width / size) * columns + (cell % width) / size;
+  }
+
+  int distance(std::uint32_t a, std::uint32_t b) const {
+    return std::abs(static_cast<int>(a % width) - static_cast<int>(b % width)) +
+           std::abs(static_cast<int>(a / width) - static_cast<int>(b / width));
+  }
+
+  // Distance found by the latest flood to a cell of the cluster.
+  int reached(std::uint32_t cell, const Cluster &cluster,
+              const Scratch &state) const {
+    int x = cell % width - cluster.x, y = cell / width - cluster.y;
+    return state.steps[y * cluster.width + x];
+  }
+
+  // Breadth-first search from a cell that never leaves the cluster, stopping
+  // early once the target is reached. State is sized to the cluster so it
+  // stays in cache. Distances are read with reached().
+  void flood(std::uint32_t from, const Cluster &cluster, Scratch &state,
+             std::uint32_t target = SearchContext::NO_PARENT) const {
+    std::vector<int> &steps = state.steps;
+    std::vector<std::uint32_t> &frontier = state.frontier;
+    int cw = cluster.width, ch = cluster.height;
+    steps.assign(cw * ch, SearchContext::UNREACHED);
+    int start = (from / width - cluster.y) * cw + from % width - cluster.x;
+    steps[start] = 0;
+    frontier.assign(1, start);
+
+    for (std::size_t head = 0; head < frontier.size(); head++) {
+      int current = frontier[head];
+      int x = current % cw, y = current / cw;
+      std::uint32_t cell = (cluster.y + y) * width + cluster.x + x;
+      if (cell == target) {
+        state.flooded += head + 1;
+        return;
+      }
+
+      for (const Vec2i &offset : CARDINAL_OFFSETS) {
+        int nx = x + offset.x, ny = y + offset.y;
+        if (nx < 0 || nx >= cw || ny < 0 || ny >= ch ||
+            steps[ny * cw + nx] != SearchContext::UNREACHED ||
+            grid.isOccupied(cluster.x + nx, cluster.y + ny)) {
+          continue;
+        }
+
+        steps[ny * cw + nx] = steps[current] + 1;
+        frontier.push_back(ny * cw + nx);
+      }
+    }
+
+    state.flooded += frontier.size();
+  }
+
+  // Cells the next step of the query may expand.
+  std::size_t upcoming(const Scratch &state) const {
+    const Cluster *cluster = nullptr;
+    switch (state.phase) {
+    case Scratch::Phase::Goal:
+      cluster = &clusters[state.last];
+      break;
+    case Scratch::Phase::Start:
+      cluster = &clusters[state.first];
+      break;
+    case Scratch::Phase::Route:
+      return 1;
+    case Scratch::Phase::Refine: {
+      std::uint32_t from = index(state.route[state.segment - 1]);
+      if (distance(from, index(state.route[state.segment])) == 1) {
+        return 0;
+      }
+
+      cluster = &clusters[clusterOf(from)];
+      break;
+    }
+    }
+
+    return static_cast<std::size_t>(cluster->width) * cluster->height;
+  }
+
+  // Floods one endpoint, expands one entrance or refines one segment.
+  void step(Scratch &state) const {
+    switch (state.phase) {
+    case Scratch::Phase::Goal: {
+      // Connect the goal to the entrances of its cluster. Movement is
+      // symmetric so distances from the goal are distances to it.
+      const Cluster &cluster = clusters[state.last];
+      flood(state.target, cluster, state);
+      state.to_goal.clear();
+      for (std::uint32_t node : cluster.nodes) {
+        state.to_goal.push_back(reached(node, cluster, state));
+      }
+
+      state.direct = state.first == state.last
+                         ? reached(state.origin, cluster, state)
+                         : SearchContext::UNREACHED;
+      state.phase = Scratch::Phase::Start;
+      break;
+    }
+    case Scratch::Phase::Start: {
+      // Connect the start the same way.
+      const Cluster &cluster = clusters[state.first];
+      flood(state.origin, cluster, state);
+      state.from_start.clear();
+      for (std::uint32_t node : cluster.nodes) {
+        state.from_start.push_back(reached(node, cluster, state));
+      }
+
+      int estimate = heuristic(state.start, state.end);
+      state.search.visit(state.origin, 0, SearchContext::NO_PARENT);
+      state.search.open.push(state.origin, {estimate, estimate});
+      state.phase = Scratch::Phase::Route;
+      break;
+    }
+    case Scratch::Phase::Route:
+      expand(state);
+      break;
+    case Scratch::Phase::Refine:
+      if (isStale(state, clusterOf(index(state.route[state.segment - 1])))) {
+        restart(state);
+        break;
+      }
+
+      refine(state.route[state.segment - 1], state.route[state.segment],
+             state.path, state);
+      if (++state.segment == state.route.size()) {
+        state.status = SearchStatus::Found;
+      }
+
+      break;
+    }
+  }
+
+  // Checks if the cluster was rebuilt after the query began.
+  bool isStale(const Scratch &state, std::size_t cluster) const {
+    return clusters[cluster].version > state.version;
+  }
+
+  // Begins the query again, keeping the count of what it expanded so far.
+  void restart(Scratch &state) const {
+    std::size_t spent = state.getExpanded();
+    begin(state.start, state.end, state);
+    state.flooded += spent;
+  }
+
+  // Expands the next entrance of the search over the clusters.
+  void expand(Scratch &state) const {
+    SearchContext &search = state.search;
+    if (search.open.empty()) {
+      state.status = SearchStatus::NotFound;
+      return;
+    }
+
+    std::uint32_t current = search.open.pop();
+    if (current == state.target) {
+      state.route = search.reconstruct(current, width);
+      state.path = {state.route[0]};
+      state.segment = 1;
+      state.phase = Scratch::Phase::Refine;
+      return;
+    }
+
+    // Distances of clusters rebuilt since the query began no longer match
+    // the ones already searched.
+    std::size_t at = clusterOf(current);
+    if (isStale(state, at) || isStale(state, state.first) ||
+        isStale(state, state.last)) {
+      restart(state);
+      return;
+    }
+
+    search.close(current);
+    int g_score = search.g(current);
+    auto relax = [&](std::uint32_t next, int cost) {
+      if (cost == SearchContext::UNREACHED ||
+          g_score + cost >= search.g(next)) {
+        return;
+      }
+
+      int h = heuristic(Vec2i(next % width, next / width), state.end);
+      search.visit(next, g_score + cost, current);
+      search.open.push(next, {g_score + cost + h, h});
+    };
+
+    if (current == state.origin) {
+      const Cluster &cluster = clusters[state.first];
+      for (std::size_t i = 0; i < cluster.nodes.size(); i++) {
+        relax(cluster.nodes[i], state.from_start[i]);
+      }
+
+      relax(state.target, state.direct);
+    }
+
+    const Cluster &cluster = clusters[at];
+    std::size_t count = cluster.nodes.size();
+    auto node = std::find(cluster.nodes.begin(), cluster.nodes.end(),
+                          current);
+    if (node == cluster.nodes.end()) {
+      return;
+    }
+
+    std::size_t i = node - cluster.nodes.begin();
+    for (std::size_t j = 0; j < count; j++) {
+      if (j != i) {
+        relax(cluster.nodes[j], cluster.distances[i * count + j]);
+      }
+    }
+
+    for (std::uint32_t link : cluster.links[i]) {
+      relax(link, 1);
+    }
+
+    if (at == state.last) {
+      relax(state.target, state.to_goal[i]);
+    }
+  }
+
+  // Adds an entrance cell linked to the cell across the border.
+  static void connect(Cluster &cluster, std::uint32_t inside,
+                      std::uint32_t outside) {
+    auto node = std::find(cluster.nodes.begin(), cluster.nodes.end(), inside);
+    if (node == cluster.nodes.end()) {
+      cluster.nodes.push_back(inside);
+      cluster.links.emplace_back();
+      node = cluster.nodes.end() - 1;
+    }
+
+    cluster.links[node - cluster.nodes.begin()].push_back(outside);
+  }
+
+  // Places entrances along one side of a cluster. Both clusters sharing a
+  // border scan it the same way so their entrances always line up.
+  void scan(Cluster &cluster, const Vec2i &side) {
+    bool vertical = side.x != 0; // Border runs top to bottom.
+    int length = vertical ? cluster.height : cluster.width;
+    int fixed = side.x < 0   ? cluster.x
+                : side.x > 0 ? cluster.x + cluster.width - 1
+                : side.y < 0 ? cluster.y
+                             : cluster.y + cluster.height - 1;
+
+    auto cell = [&](int t) {
+      return vertical ? Vec2i(fixed, cluster.y + t)
+                      : Vec2i(cluster.x + t, fixed);
+    };
+
+    auto add = [&](int t) {
+      Vec2i inside = cell(t);
+      connect(cluster, index(inside), index(inside + side));
+    };
+
+    int run = 0;
+    for (int t = 0; t <= length; t++) {
+      Vec2i inside = cell(t), outside = inside + side;
+      if (t < length && walkable(inside.x, inside.y) &&
+          walkable(outside.x, outside.y)) {
+        run++;
+        continue;
+      } else if (run == 0) {
+        continue;
+      }
+
+      // Narrow entrances get a node in the middle, wide ones at both ends.
+      if (run <= MAX_NARROW) {
+        add(t - run + run / 2);
+      } else {
+        add(t - run);
+        add(t - 1);
+      }
+
+      run = 0;
+    }
+  }
+
+  // Recomputes the entrances of a cluster and the distances between them.
+  void refresh(std::size_t i) {
+    Cluster &cluster = clusters[i];
+    cluster.version = ++version;
+    cluster.nodes.clear();
+    cluster.links.clear();
+    for (const Vec2i &side : CARDINAL_OFFSETS) {
+      scan(cluster, side);
+    }
+
+    std::size_t count = cluster.nodes.size();
+    cluster.distances.assign(count * count, SearchContext::UNREACHED);
+    for (std::size_t a = 0; a < count; a++) {
+      flood(cluster.nodes[a], cluster, scratch);
+      for (std::size_t b = 0; b < count; b++) {
+        cluster.distances[a * count + b] =
+            reached(cluster.nodes[b], cluster, scratch);
+      }
+    }
+  }
+};
+
+} // namespace pathfind
+
+#endif
\ No newline at end of file
@@ -0,0 +1,387 @@
+#ifndef _PATHFIND_JPS_HPP
+#define _PATHFIND_JPS_HPP
+
+#include "context.hpp"
+#include "neighborhood.hpp"
+#include "util.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace pathfind {
+
+// Selects how jump points are located.
+enum class JumpMode {
+  Online,      // Scans the grid while searching (JPS).
+  Precomputed, // Reads jump distances built ahead of time (JPS+).
+};
+
+// Jump Point Search for grids where every passable cell costs the same.
+// Symmetric paths are pruned by only expanding jump points, cells where the
+// optimal path may change direction. Diagonal movement follows the same rules
+// as A* (corners may be cut) and diagonal steps cost roughly sqrt(2).
+//
+// Accessor: getWidth(), getHeight() and isOccupied(x, y).
+template <typename Accessor, typename Neighborhood = FourWay>
+class JumpPointSearch {
+  static_assert(!Neighborhood::WRAP,
+                "Jump point search does not support wrapping grids");
+  static constexpr bool DIAGONAL = Neighborhood::DIAGONAL;
+  static constexpr int STRAIGHT = 5, DIAGONAL_COST = 7; // Step costs.
+
+public:
+  explicit JumpPointSearch(Accessor grid, JumpMode mode = JumpMode::Online)
+      : grid(grid), mode(mode), width(grid.getWidth()),
+        height(grid.getHeight()) {
+    if (width == 0 || height == 0) {
+      throw std::runtime_error("Invalid dimensions for grid provided.");
+    }
+
+    if (mode == JumpMode::Precomputed) {
+      precompute();
+    }
+  }
+
+  int getHeight() const { return height; } // Height of the grid.
+  int getWidth() const { return width; }   // Width of the grid.
+
+  // Amount of jump points expanded by the latest search.
+  std::size_t getExpanded() const { return context.getExpanded(); }
+
+  // Rebuilds the jump distances for JumpMode::Precomputed, required after the
+  // grid changes.
+  void precompute() {
+    if (width > INT16_MAX || height > INT16_MAX) {
+      throw std::runtime_error("Grid is too large for jump distances.");
+    }
+
+    jumps.assign(static_cast<std::size_t>(width) * height * 8, 0);
+
+    // Cardinal distances first, the others stop where a cardinal jump does.
+    for (int d = 0; d < 4; d++) {
+      if (DIAGONAL || ALL_OFFSETS[d].x != 0) {
+        sweep(d);
+      }
+    }
+
+    for (int d = DIAGONAL ? 4 : 0; d < (DIAGONAL ? 8 : 4); d++) {
+      if (DIAGONAL || ALL_OFFSETS[d].x == 0) {
+        sweep(d);
+      }
+    }
+  }
+
+  // Finds the path from start to end, including every cell along the way.
+  std::vector<Vec2i> findPath(const Vec2i &start, const Vec2i &end) {
+    if (!isValid(start) || !isValid(end)) {
+      throw std::runtime_error(
+          "Invalid start or end position for pathfinding.");
+    } else if (!walkable(start.x, start.y) || !walkable(end.x, end.y)) {
+      return {};
+    }
+
+    goal = end;
+    context.begin(static_cast<std::size_t>(width) * height);
+    std::uint32_t origin = index(start), target = index(end);
+    int h = distance(start, end);
+    context.visit(origin, 0, SearchContext::NO_PARENT);
+    context.open.push(origin, {h, h});
+
+    std::array<Vec2i, 8> directions = ALL_OFFSETS;
+    while (!context.open.empty()) {
+      std::uint32_t current = context.open.pop();
+      if (current == target) {
+        return expand(context.reconstruct(current, width));
+      }
+
+      context.close(current);
+      Vec2i position(current % width, current / width);
+      int count = prune(position, context.parent(current), directions);
+
+      for (int i = 0; i < count; i++) {
+        std::optional<Vec2i> point = mode == JumpMode::Online
+                                         ? jump(position, directions[i])
+                                         : lookup(position, directions[i]);
+        if (!point) {
+          continue;
+        }
+
+        std::uint32_t successor = index(*point);
+        int g_score = context.g(current) + distance(position, *point);
+        if (g_score >= context.g(successor)) {
+          continue;
+        }
+
+        h = distance(*point, goal);
+        context.visit(successor, g_score, current);
+        context.open.push(successor, {g_score + h, h});
+      }
+    }
+
+    return {};
+  }
+
+private:
+  Accessor grid;         // Grid being processed.
+  JumpMode mode;         // How jump points are located.
+  int width, height;     // Dimensions of the inner grid.
+  Vec2i goal = {0, 0};   // Goal of the current search.
+  SearchContext context; // Search state reused between searches.
+
+  // Signed jump distances per cell and direction (ALL_OFFSETS order). A
+  // positive value n is a jump point n steps away, otherwise -n cells are
+  // passable before hitting an obstacle or the border.
+  std::vector<std::int16_t> jumps;
+
+  bool isValid(const Vec2i &position) const {
+    return position.x >= 0 && position.x < width && position.y >= 0 &&
+           position.y < height;
+  }
+
+  bool walkable(int x, int y) const {
+    return x >= 0 && x < width && y >= 0 && y < height &&
+           !grid.isOccupied(x, y);
+  }
+
+  std::uint32_t index(const Vec2i &position) const {
+    return position.y * width + position.x;
+  }
+
+  // Cost of moving between two cells along a straight or diagonal line, also
+  // used as the heuristic.
+  static int distance(const Vec2i &a, const Vec2i &b) {
+    int dx = std::abs(a.x - b.x), dy = std::abs(a.y - b.y);
+    if constexpr (DIAGONAL) {
+      return STRAIGHT * std::max(dx, dy) +
+             (DIAGONAL_COST - STRAIGHT) * std::min(dx, dy);
+    } else {
+      return STRAIGHT * (dx + dy);
+    }
+  }
+
+  static int sign(int value) { return (value > 0) - (value < 0); }
+
+  // Index of a unit offset within ALL_OFFSETS.
+  static int direction(const Vec2i &offset) {
+    constexpr int lookup[9] = {7, 0, 4, 3, -1, 1, 6, 2, 5};
+    return lookup[(offset.y + 1) * 3 + offset.x + 1];
+  }
+
+  // Checks if the cell forces a turn when entered travelling along offset,
+  // that is a neighbor is only reached optimally through this cell.
+  bool isForced(int x, int y, const Vec2i &offset) const {
+    int dx = offset.x, dy = offset.y;
+    if constexpr (DIAGONAL) {
+      if (dx != 0 && dy != 0) {
+        return (walkable(x - dx, y + dy) && !walkable(x - dx, y)) ||
+               (walkable(x + dx, y - dy) && !walkable(x, y - dy));
+      } else if (dx != 0) {
+        return (walkable(x + dx, y + 1) && !walkable(x, y + 1)) ||
+               (walkable(x + dx, y - 1) && !walkable(x, y - 1));
+      }
+
+      return (walkable(x + 1, y + dy) && !walkable(x + 1, y)) ||
+             (walkable(x - 1, y + dy) && !walkable(x - 1, y));
+    } else {
+      if (dx != 0) {
+        return (walkable(x, y - 1) && !walkable(x - dx, y - 1)) ||
+               (walkable(x, y + 1) && !walkable(x - dx, y + 1));
+      }
+
+      return (walkable(x - 1, y) && !walkable(x - 1, y - dy)) ||
+             (walkable(x + 1, y) && !walkable(x + 1, y - dy));
+    }
+  }
+
+  // Directions worth exploring from a cell given the direction it was
+  // entered from, written into out. Returns the amount of directions.
+  int prune(const Vec2i &position, std::uint32_t parent,
+            std::array<Vec2i, 8> &out) const {
+    if (parent == SearchContext::NO_PARENT) {
+      std::copy(ALL_OFFSETS.begin(), ALL_OFFSETS.end(), out.begin());
+      return DIAGONAL ? 8 : 4;
+    }
+
+    int x = position.x, y = position.y;
+    int dx = sign(x - static_cast<int>(parent % width));
+    int dy = sign(y - static_cast<int>(parent / width));
+    int count = 0;
+
+    if constexpr (DIAGONAL) {
+      if (dx != 0 && dy != 0) {
+        out[count++] = {0, dy};
+        out[count++] = {dx, 0};
+        out[count++] = {dx, dy};
+        if (!walkable(x - dx, y)) {
+          out[count++] = {-dx, dy};
+        }
+
+        if (!walkable(x, y - dy)) {
+          out[count++] = {dx, -dy};
+        }
+      } else if (dx != 0) {
+        out[count++] = {dx, 0};
+        if (!walkable(x, y + 1)) {
+          out[count++] = {dx, 1};
+        }
+
+        if (!walkable(x, y - 1)) {
+          out[count++] = {dx, -1};
+        }
+      } else {
+        out[count++] = {0, dy};
+        if (!walkable(x + 1, y)) {
+          out[count++] = {1, dy};
+        }
+
+        if (!walkable(x - 1, y)) {
+          out[count++] = {-1, dy};
+        }
+      }
+    } else {
+      if (dx != 0) {
+        out[count++] = {dx, 0};
+        out[count++] = {0, 1};
+        out[count++] = {0, -1};
+      } else {
+        out[count++] = {0, dy};
+        out[count++] = {1, 0};
+        out[count++] = {-1, 0};
+      }
+    }
+
+    return count;
+  }
+
+  // Travels from a cell along offset until a jump point, the goal, or an
+  // obstacle is reached.
+  std::optional<Vec2i> jump(Vec2i position, const Vec2i &offset) const {
+    int dx = offset.x, dy = offset.y;
+    while (true) {
+      position = position + offset;
+      if (!walkable(position.x, position.y)) {
+        return std::nullopt;
+      } else if (position == goal || isForced(position.x, position.y, offset)) {
+        return position;
+      }
+
+      // Diagonal (or vertical on 4-connected grids) travel stops where a
+      // cardinal jump would find something.
+      if constexpr (DIAGONAL) {
+        if (dx != 0 && dy != 0 &&
+            (jump(position, {dx, 0}) || jump(position, {0, dy}))) {
+          return position;
+        }
+      } else {
+        if (dx == 0 && (jump(position, {1, 0}) || jump(position, {-1, 0}))) {
+          return position;
+        }
+      }
+    }
+  }
+
+  // Jump distance from a cell in a direction.
+  int jumpAt(int x, int y, int d) const {
+    return jumps[(static_cast<std::size_t>(y) * width + x) * 8 + d];
+  }
+
+  // Fills the jump distances for a direction, visiting cells so that the
+  // next cell along the direction is always computed first.
+  void sweep(int d) {
+    const Vec2i &offset = ALL_OFFSETS[d];
+    int dx = offset.x, dy = offset.y;
+    for (int row = 0; row < height; row++) {
+      int y = dy > 0 ? height - 1 - row : row;
+      for (int col = 0; col < width; col++) {
+        int x = dx > 0 ? width - 1 - col : col;
+        int nx = x + dx, ny = y + dy;
+        int value = 0;
+
+        if (walkable(nx, ny)) {
+          bool stops = isForced(nx, ny, offset);
+          if constexpr (DIAGONAL) {
+            stops = stops || (dx != 0 && dy != 0 &&
+                              (jumpAt(nx, ny, direction({dx, 0})) > 0 ||
+                               jumpAt(nx, ny, direction({0, dy})) > 0));
+          } else {
+            stops = stops || (dx == 0 &&
+                              (jumpAt(nx, ny, direction({1, 0})) > 0 ||
+                               jumpAt(nx, ny, direction({-1, 0})) > 0));
+          }
+
+          int next = jumpAt(nx, ny, d);
+          value = stops ? 1 : (next > 0 ? next + 1 : next - 1);
+        }
+
+        jumps[(static_cast<std::size_t>(y) * width + x) * 8 + d] = value;
+      }
+    }
+  }
+
+  // Locates the next jump point using the precomputed distances. The goal
+  // is not known ahead of time, so it is checked against the free distance.
+  std::optional<Vec2i> lookup(const Vec2i &position,
+                              const Vec2i &offset) const {
+    int value = jumpAt(position.x, position.y, direction(offset));
+    int reach = std::abs(value); // Cells that can be travelled to.
+    int dx = offset.x, dy = offset.y;
+    int gx = goal.x - position.x, gy = goal.y - position.y;
+
+    if (dx != 0 && dy != 0) {
+      // Stop where the goal shares a row or column with the diagonal.
+      if (sign(gx) == dx && sign(gy) == dy) {
+        int steps = std::min(std::abs(gx), std::abs(gy));
+        if (steps <= reach) {
+          return Vec2i(position.x + dx * steps, position.y + dy * steps);
+        }
+      }
+    } else if (dx != 0) {
+      if (gy == 0 && sign(gx) == dx && std::abs(gx) <= reach) {
+        return goal;
+      }
+    } else if (sign(gy) == dy && std::abs(gy) <= reach) {
+      if (gx == 0) {
+        return goal;
+      } else if (!DIAGONAL) {
+        // Vertical travel stops at the goal row to turn towards it.
+        return Vec2i(position.x, goal.y);
+      }
+    }
+
+    if (value > 0) {
+      return Vec2i(position.x + dx * value, position.y + dy * value);
+    }
+
+    return std::nullopt;
+  }
+
+  // Fills in the cells between consecutive jump points.
+  static std::vector<Vec2i> expand(const std::vector<Vec2i> &points) {
+    std::vector<Vec2i> path;
+    if (points.empty()) {
+      return path;
+    }
+
+    path.push_back(points[0]);
+    for (std::size_t i = 1; i < points.size(); i++) {
+      Vec2i step(sign(points[i].x - points[i - 1].x),
+                 sign(points[i].y - points[i - 1].y));
+      Vec2i at = points[i - 1];
+      while (at != points[i]) {
+        at = at + step;
+        path.push_back(at);
+      }
+    }
+
+    return path;
+  }
+};
+
+} // namespace pathfind
+
+#endif
\ No newline at end of file
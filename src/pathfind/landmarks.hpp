@@ -0,0 +1,209 @@
+#ifndef _PATHFIND_LANDMARKS_HPP
+#define _PATHFIND_LANDMARKS_HPP
+
+#include "../util/threadpool.hpp"
+#include "heuristic.hpp"
+#include "neighborhood.hpp"
+#include "util.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace pathfind {
+
+// Distances from a few landmark cells to every cell, used to estimate the
+// distance between two cells with the triangle inequality (ALT). Unlike the
+// geometric heuristics, the estimate accounts for obstacles such as water
+// that a path has to go around.
+//
+// Accessor: getWidth(), getHeight() and isOccupied(x, y).
+template <typename Accessor, typename Neighborhood = FourWay> class Landmarks {
+public:
+  static constexpr std::uint16_t UNREACHED = UINT16_MAX;
+
+  Landmarks(Accessor grid, std::size_t count)
+      : grid(grid), width(grid.getWidth()), height(grid.getHeight()),
+        requested(count) {
+    if (width == 0 || height == 0) {
+      throw std::runtime_error("Invalid dimensions for grid provided.");
+    }
+
+    rebuild();
+  }
+
+  int getHeight() const { return height; } // Height of the grid.
+  int getWidth() const { return width; }   // Width of the grid.
+
+  // Cells selected as landmarks.
+  const std::vector<Vec2i> &getLandmarks() const { return landmarks; }
+
+  // Selects the landmarks and computes their distances, one landmark per
+  // worker. Required after a cell opens up, distances across it may have
+  // shrunk. Blocking cells only lengthens paths so stale distances still
+  // underestimate.
+  void rebuild() {
+    select();
+
+    std::size_t cells = static_cast<std::size_t>(width) * height;
+    distances.assign(cells * landmarks.size(), UNREACHED);
+    if (landmarks.empty()) {
+      return;
+    }
+
+    if (!workers) {
+      std::size_t threads = std::thread::hardware_concurrency();
+      workers = std::make_unique<ThreadPool>(
+          std::clamp<std::size_t>(threads, 1, requested));
+    }
+
+    // Each landmark floods its own column so workers never write to the
+    // same cache lines, the columns are interleaved afterwards.
+    columns.resize(landmarks.size());
+    for (std::size_t i = 0; i < landmarks.size(); i++) {
+      workers->submit([this, i] { flood(i); });
+    }
+
+    workers->wait();
+    std::size_t count = landmarks.size();
+    for (std::size_t i = 0; i < count; i++) {
+      const std::uint16_t *column = columns[i].data();
+      for (std::size_t cell = 0; cell < cells; cell++) {
+        distances[cell * count + i] = column[cell];
+      }
+    }
+  }
+
+  // Lower bound on the steps between two cells. Cells that a landmark cannot
+  // reach are skipped, they give no information.
+  int estimate(const Vec2i &a, const Vec2i &b) const {
+    std::size_t count = landmarks.size();
+    const std::uint16_t *from = &distances[index(a) * count];
+    const std::uint16_t *to = &distances[index(b) * count];
+
+    int best = 0;
+    for (std::size_t i = 0; i < count; i++) {
+      if (from[i] != UNREACHED && to[i] != UNREACHED) {
+        best = std::max(best, std::abs(from[i] - to[i]));
+      }
+    }
+
+    return best;
+  }
+
+private:
+  Accessor grid;             // Grid being processed.
+  int width, height;         // Dimensions of the inner grid.
+  std::size_t requested;     // Amount of landmarks to select.
+  std::vector<Vec2i> landmarks;
+
+  // Distances per cell, the landmarks of a cell are stored next to each
+  // other so an estimate reads two short runs. Distances are clamped below
+  // UNREACHED, which keeps them a lower bound.
+  std::vector<std::uint16_t> distances;
+
+  std::vector<std::vector<std::uint16_t>> columns; // Distances per landmark.
+  std::unique_ptr<ThreadPool> workers;             // Created on first use.
+
+  std::size_t index(const Vec2i &position) const {
+    return static_cast<std::size_t>(position.y) * width + position.x;
+  }
+
+  // Spreads the landmarks evenly along the border, where they sit behind
+  // most goals, snapping each to the closest passable cell.
+  void select() {
+    landmarks.clear();
+    int perimeter = 2 * (width + height);
+    for (std::size_t i = 0; i < requested; i++) {
+      int t = static_cast<int>(i * perimeter / requested);
+      Vec2i point = t < width                ? Vec2i(t, 0)
+                    : t < width + height     ? Vec2i(width - 1, t - width)
+                    : t < 2 * width + height ? Vec2i(2 * width + height - 1 - t,
+                                                     height - 1)
+                                             : Vec2i(0, perimeter - 1 - t);
+
+      Vec2i landmark(0, 0);
+      if (nearestOpen(point, landmark) &&
+          std::find(landmarks.begin(), landmarks.end(), landmark) ==
+              landmarks.end()) {
+        landmarks.push_back(landmark);
+      }
+    }
+  }
+
+  // Searches rings of growing size around the point for a passable cell.
+  bool nearestOpen(const Vec2i &point, Vec2i &found) const {
+    int limit = std::max(width, height);
+    for (int radius = 0; radius < limit; radius++) {
+      for (int dy = -radius; dy <= radius; dy++) {
+        for (int dx = -radius; dx <= radius; dx++) {
+          if (std::max(std::abs(dx), std::abs(dy)) != radius) {
+            continue;
+          }
+
+          int x = point.x + dx, y = point.y + dy;
+          if (x >= 0 && x < width && y >= 0 && y < height &&
+              !grid.isOccupied(x, y)) {
+            found = Vec2i(x, y);
+            return true;
+          }
+        }
+      }
+    }
+
+    return false;
+  }
+
+  // Breadth-first search from a landmark, writing only its own column.
+  void flood(std::size_t landmark) {
+    std::vector<std::uint16_t> &column = columns[landmark];
+    column.assign(static_cast<std::size_t>(width) * height, UNREACHED);
+    Neighborhood neighborhood;
+    std::vector<Vec2i> frontier = {landmarks[landmark]};
+    column[index(landmarks[landmark])] = 0;
+
+    for (std::size_t head = 0; head < frontier.size(); head++) {
+      Vec2i current = frontier[head];
+      std::uint16_t steps = column[index(current)];
+      steps = std::min<std::uint16_t>(steps + 1, UNREACHED - 1);
+
+      for (const Vec2i &offset : neighborhood.offsets()) {
+        Vec2i neighbor = current + offset;
+        if (!neighborhood.resolve(neighbor, width, height)) {
+          continue;
+        }
+
+        std::uint16_t &distance = column[index(neighbor)];
+        if (distance == UNREACHED && !grid.isOccupied(neighbor.x, neighbor.y)) {
+          distance = steps;
+          frontier.push_back(neighbor);
+        }
+      }
+    }
+  }
+};
+
+// Heuristic policy for BasicAStar combining landmark estimates with a
+// geometric heuristic, taking whichever is larger.
+template <typename Landmarks, typename Base = ManhattanHeuristic>
+class LandmarkHeuristic {
+public:
+  explicit LandmarkHeuristic(const Landmarks &landmarks, Base base = Base())
+      : landmarks(&landmarks), base(base) {}
+
+  int operator()(const Vec2i &start, const Vec2i &end) const {
+    return std::max(base(start, end), landmarks->estimate(start, end));
+  }
+
+private:
+  const Landmarks *landmarks;
+  Base base;
+};
+
+} // namespace pathfind
+
+#endif
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef _PATHFIND_NEIGHBORHOOD_HPP
+#define _PATHFIND_NEIGHBORHOOD_HPP
+
+#include "util.hpp"
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace pathfind {
+
+// Offsets to the cardinal neighbors, followed by the diagonal neighbors.
+inline constexpr std::array<Vec2i, 4> CARDINAL_OFFSETS = {
+    {{0, -1}, {1, 0}, {0, 1}, {-1, 0}}};
+inline constexpr std::array<Vec2i, 8> ALL_OFFSETS = {
+    {{0, -1}, {1, 0}, {0, 1}, {-1, 0}, {1, -1}, {1, 1}, {-1, 1}, {-1, -1}}};
+
+// Neighborhood policy with the offsets fixed at compile time.
+template <bool Diagonal, bool Wrap> struct Neighborhood {
+  static constexpr bool DIAGONAL = Diagonal;
+  static constexpr bool WRAP = Wrap;
+  static constexpr std::size_t COUNT = Diagonal ? 8 : 4;
+
+  static constexpr std::array<Vec2i, COUNT> OFFSETS = [] {
+    if constexpr (Diagonal) {
+      return ALL_OFFSETS;
+    } else {
+      return CARDINAL_OFFSETS;
+    }
+  }();
+
+  const std::array<Vec2i, COUNT> &offsets() const { return OFFSETS; }
+
+  // Wraps the neighbor around the borders if enabled, returning false if it
+  // falls outside of the grid.
+  bool resolve(Vec2i &neighbor, int width, int height) const {
+    if constexpr (Wrap) {
+      neighbor.x = (neighbor.x + width) % width;
+      neighbor.y = (neighbor.y + height) % height;
+      return true;
+    } else {
+      return neighbor.x >= 0 && neighbor.x < width && neighbor.y >= 0 &&
+             neighbor.y < height;
+    }
+  }
+};
+
+using FourWay = Neighborhood<false, false>;
+using EightWay = Neighborhood<true, false>;
+using FourWayWrap = Neighborhood<false, true>;
+using EightWayWrap = Neighborhood<true, true>;
+
+// Neighborhood selected at runtime.
+class DynamicNeighborhood {
+public:
+  DynamicNeighborhood(bool allow_diagonal, bool wrap)
+      : wrap(wrap), offsets_(CARDINAL_OFFSETS.begin(), CARDINAL_OFFSETS.end()) {
+    if (allow_diagonal) {
+      offsets_.assign(ALL_OFFSETS.begin(), ALL_OFFSETS.end());
+    }
+  }
+
+  const std::vector<Vec2i> &offsets() const { return offsets_; }
+
+  // Wraps the neighbor around the borders if enabled, returning false if it
+  // falls outside of the grid.
+  bool resolve(Vec2i &neighbor, int width, int height) const {
+    if (wrap) {
+      neighbor.x = (neighbor.x + width) % width;
+      neighbor.y = (neighbor.y + height) % height;
+      return true;
+    }
+
+    return neighbor.x >= 0 && neighbor.x < width && neighbor.y >= 0 &&
+           neighbor.y < height;
+  }
+
+private:
+  bool wrap;                   // Allow looping around borders of the grid.
+  std::vector<Vec2i> offsets_; // Offsets to get neighboring cells.
+};
+
+} // namespace pathfind
+
+#endif
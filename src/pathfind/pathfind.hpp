@@ -2,7 +2,19 @@
 #define _PATHFIND_HPP
 
 #include "astar.hpp"
+#include "bitgrid.hpp"
+#include "clearance.hpp"
+#include "context.hpp"
+#include "dstar.hpp"
+#include "flowfield.hpp"
 #include "grid.hpp"
+#include "heap.hpp"
+#include "heuristic.hpp"
+#include "hpa.hpp"
+#include "jps.hpp"
+#include "landmarks.hpp"
+#include "neighborhood.hpp"
+#include "regions.hpp"
 #include "util.hpp"
 
 #endif
\ No newline at end of file
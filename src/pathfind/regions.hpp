@@ -0,0 +1,339 @@
+#ifndef _PATHFIND_REGIONS_HPP
+#define _PATHFIND_REGIONS_HPP
+
+#include "neighborhood.hpp"
+#include "util.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace pathfind {
+
+// Labels the connected regions of passable cells so reachability between two
+// cells is a comparison. Labels are merged with a union-find when a cell opens
+// up, and only the pieces cut off by a newly blocked cell are relabeled.
+//
+// Accessor: getWidth(), getHeight() and isOccupied(x, y).
+template <typename Accessor, typename Neighborhood = FourWay>
+class ConnectedRegions {
+  static constexpr std::size_t COUNT = Neighborhood::COUNT;
+  static constexpr std::size_t DEAD_SHARE = 8; // Cells per dead label.
+
+public:
+  static constexpr std::uint32_t NONE = 0; // Region of occupied cells.
+
+  explicit ConnectedRegions(Accessor grid)
+      : grid(grid), width(grid.getWidth()), height(grid.getHeight()) {
+    if (width == 0 || height == 0) {
+      throw std::runtime_error("Invalid dimensions for grid provided.");
+    }
+
+    rebuild();
+  }
+
+  int getHeight() const { return height; } // Height of the grid.
+  int getWidth() const { return width; }   // Width of the grid.
+
+  // Labels every cell from scratch.
+  void rebuild() {
+    std::size_t cells = static_cast<std::size_t>(width) * height;
+    labels.assign(cells, NONE);
+    parents.assign(1, NONE);
+    sizes.assign(1, 0);
+    live = 0;
+    stamps.assign(cells, 0);
+    owners.assign(cells, 0);
+    generation = 0;
+
+    for (std::uint32_t cell = 0; cell < cells; cell++) {
+      if (labels[cell] != NONE || occupied(cell)) {
+        continue;
+      }
+
+      std::uint32_t label = create();
+      labels[cell] = label;
+      probes[0].assign(1, cell);
+      for (std::size_t head = 0; head < probes[0].size(); head++) {
+        forEachNeighbor(probes[0][head], [&](std::uint32_t next) {
+          if (labels[next] == NONE && !occupied(next)) {
+            labels[next] = label;
+            probes[0].push_back(next);
+          }
+        });
+      }
+
+      sizes[label] = probes[0].size();
+    }
+  }
+
+  // Region of the position, NONE if it is occupied or outside the grid.
+  // Regions may be renumbered by update().
+  std::uint32_t region(const Vec2i &position) const {
+    if (!isValid(position)) {
+      return NONE;
+    }
+
+    return find(labels[index(position)]);
+  }
+
+  // Checks if a path exists between two positions.
+  bool isConnected(const Vec2i &a, const Vec2i &b) const {
+    std::uint32_t label = region(a);
+    return label != NONE && label == region(b);
+  }
+
+  // Updates the regions after the cell at (x, y) changed passability.
+  void update(int x, int y) {
+    std::uint32_t cell = index(Vec2i(x, y));
+    bool was_open = labels[cell] != NONE;
+    if (was_open == !occupied(cell)) {
+      return;
+    } else if (was_open) {
+      close(cell);
+    } else {
+      open(cell);
+    }
+
+    // Merged and emptied labels are never reused, renumber once they make
+    // up a fair share so memory and lookups stay bounded.
+    if ((parents.size() - 1 - live) * DEAD_SHARE > labels.size()) {
+      compact();
+    }
+  }
+
+private:
+  Accessor grid;     // Grid being processed.
+  int width, height; // Dimensions of the inner grid.
+
+  std::vector<std::uint32_t> labels;  // Label of every cell, NONE if occupied.
+  std::vector<std::uint32_t> parents; // Union-find parent of every label.
+  std::vector<std::size_t> sizes;     // Cells of every root label.
+  std::size_t live = 0;               // Root labels, the rest are merged.
+
+  // Scratch state for splitting a region, one search per neighbor.
+  std::array<std::vector<std::uint32_t>, COUNT> probes;
+  std::vector<std::uint32_t> stamps; // Generation a cell was searched.
+  std::vector<std::uint8_t> owners;  // Search that reached a cell.
+  std::uint32_t generation = 0;
+
+  bool isValid(const Vec2i &position) const {
+    return position.x >= 0 && position.x < width && position.y >= 0 &&
+           position.y < height;
+  }
+
+  std::uint32_t index(const Vec2i &position) const {
+    return position.y * width + position.x;
+  }
+
+  bool occupied(std::uint32_t cell) const {
+    return grid.isOccupied(cell % width, cell / width);
+  }
+
+  template <typename Fn>
+  void forEachNeighbor(std::uint32_t cell, Fn &&fn) const {
+    Neighborhood neighborhood;
+    Vec2i position(cell % width, cell / width);
+    for (const Vec2i &offset : Neighborhood::OFFSETS) {
+      Vec2i neighbor = position + offset;
+      if (neighborhood.resolve(neighbor, width, height)) {
+        fn(index(neighbor));
+      }
+    }
+  }
+
+  // Root label of a label.
+  std::uint32_t find(std::uint32_t label) const {
+    while (parents[label] != label) {
+      label = parents[label];
+    }
+
+    return label;
+  }
+
+  // Root label of a label, halving the path on the way.
+  std::uint32_t find(std::uint32_t label) {
+    while (parents[label] != label) {
+      parents[label] = parents[parents[label]];
+      label = parents[label];
+    }
+
+    return label;
+  }
+
+  // Creates a new root label.
+  std::uint32_t create() {
+    std::uint32_t label = parents.size();
+    parents.push_back(label);
+    sizes.push_back(0);
+    live++;
+    return label;
+  }
+
+  // Renumbers the regions that still have cells, every label a root.
+  void compact() {
+    std::vector<std::uint32_t> renamed(parents.size(), NONE);
+    std::vector<std::size_t> kept(1, 0);
+    for (std::uint32_t &label : labels) {
+      if (label == NONE) {
+        continue;
+      }
+
+      std::uint32_t root = find(label);
+      if (renamed[root] == NONE) {
+        renamed[root] = kept.size();
+        kept.push_back(sizes[root]);
+      }
+
+      label = renamed[root];
+    }
+
+    parents.resize(kept.size());
+    for (std::uint32_t i = 0; i < parents.size(); i++) {
+      parents[i] = i;
+    }
+
+    sizes = std::move(kept);
+    live = sizes.size() - 1;
+  }
+
+  // Joins the cell to the regions around it, merging them into the largest.
+  void open(std::uint32_t cell) {
+    std::uint32_t target = NONE;
+    forEachNeighbor(cell, [&](std::uint32_t next) {
+      std::uint32_t root = find(labels[next]);
+      if (root != NONE && (target == NONE || sizes[root] > sizes[target])) {
+        target = root;
+      }
+    });
+
+    if (target == NONE) {
+      target = create();
+    }
+
+    forEachNeighbor(cell, [&](std::uint32_t next) {
+      std::uint32_t root = find(labels[next]);
+      if (root != NONE && root != target) {
+        parents[root] = target;
+        sizes[target] += sizes[root];
+        live--;
+      }
+    });
+
+    labels[cell] = target;
+    sizes[target]++;
+  }
+
+  // Removes the cell from its region. Its neighbors are searched from in
+  // lockstep, searches that meet are merged and a merged search that runs
+  // out of cells before the rest is a piece that was cut off. Only those
+  // pieces are relabeled, the remaining piece keeps the label.
+  void close(std::uint32_t cell) {
+    std::uint32_t root = find(labels[cell]);
+    labels[cell] = NONE;
+    sizes[root]--;
+
+    if (++generation == 0) {
+      std::fill(stamps.begin(), stamps.end(), 0);
+      generation = 1;
+    }
+
+    // Start a search from every neighbor that belongs to the region.
+    std::size_t count = 0;
+    std::array<std::size_t, COUNT> heads = {}, groups = {};
+    forEachNeighbor(cell, [&](std::uint32_t next) {
+      if (labels[next] != NONE && stamps[next] != generation) {
+        stamps[next] = generation;
+        owners[next] = count;
+        probes[count].assign(1, next);
+        groups[count] = count;
+        count++;
+      }
+    });
+
+    auto groupOf = [&](std::size_t probe) {
+      while (groups[probe] != probe) {
+        probe = groups[probe];
+      }
+
+      return probe;
+    };
+
+    std::array<bool, COUNT> done = {};
+    while (true) {
+      // Separate groups and whether each still has cells to search.
+      std::array<bool, COUNT> active = {}, present = {};
+      std::size_t separate = 0;
+      for (std::size_t i = 0; i < count; i++) {
+        if (done[i]) {
+          continue;
+        }
+
+        std::size_t group = groupOf(i);
+        separate += !present[group];
+        present[group] = true;
+        active[group] = active[group] || heads[i] < probes[i].size();
+      }
+
+      if (separate <= 1) {
+        return;
+      }
+
+      // Relabel a group that was cut off from the rest.
+      bool split = false;
+      for (std::size_t group = 0; group < count && !split; group++) {
+        if (!present[group] || active[group]) {
+          continue;
+        }
+
+        std::uint32_t label = create();
+        for (std::size_t i = 0; i < count; i++) {
+          if (!done[i] && groupOf(i) == group) {
+            for (std::uint32_t piece : probes[i]) {
+              labels[piece] = label;
+            }
+
+            sizes[label] += probes[i].size();
+            done[i] = true;
+          }
+        }
+
+        sizes[root] -= sizes[label];
+        split = true;
+      }
+
+      if (split) {
+        continue;
+      }
+
+      // Advance every search by one cell.
+      for (std::size_t i = 0; i < count; i++) {
+        if (done[i] || heads[i] == probes[i].size()) {
+          continue;
+        }
+
+        std::uint32_t current = probes[i][heads[i]++];
+        forEachNeighbor(current, [&](std::uint32_t next) {
+          if (labels[next] == NONE || find(labels[next]) != root) {
+            return;
+          } else if (stamps[next] == generation) {
+            std::size_t a = groupOf(i), b = groupOf(owners[next]);
+            groups[std::max(a, b)] = std::min(a, b);
+            return;
+          }
+
+          stamps[next] = generation;
+          owners[next] = i;
+          probes[i].push_back(next);
+        });
+      }
+    }
+  }
+};
+
+} // namespace pathfind
+
+#endif
\ No newline at end of file
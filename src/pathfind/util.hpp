@@ -7,9 +7,9 @@
 struct Vec2i {
   int x, y;
 
-  Vec2i(int x, int y) : x(x), y(y) {}
+  constexpr Vec2i(int x, int y) : x(x), y(y) {}
 
-  Vec2i operator+(const Vec2i &other) const {
+  constexpr Vec2i operator+(const Vec2i &other) const {
     return {x + other.x, y + other.y};
   }
   friend bool operator==(const Vec2i &a, const Vec2i &b) {
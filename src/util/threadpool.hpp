@@ -0,0 +1,107 @@
+#ifndef _THREAD_POOL_HPP
+#define _THREAD_POOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that process submitted tasks in FIFO order.
+class ThreadPool {
+public:
+  explicit ThreadPool(std::size_t threads) {
+    threads = std::max<std::size_t>(threads, 1);
+    for (std::size_t i = 0; i < threads; i++) {
+      workers.emplace_back([this] { run(); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+
+    available.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Amount of worker threads.
+  std::size_t size() const { return workers.size(); }
+
+  // Queues a task to be ran by the next available worker.
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.push(std::move(task));
+      pending++;
+    }
+
+    available.notify_one();
+  }
+
+  // Blocks until every submitted task has completed. Rethrows the first
+  // exception raised by a task, if any.
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return pending == 0; });
+
+    if (error) {
+      std::exception_ptr raised = error;
+      error = nullptr;
+      std::rethrow_exception(raised);
+    }
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::queue<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable available; // Signals new tasks or shutdown.
+  std::condition_variable finished;  // Signals all tasks are complete.
+  std::size_t pending = 0;           // Tasks queued or running.
+  bool stopping = false;
+  std::exception_ptr error; // First exception raised by a task.
+
+  // Worker loop, processes tasks until the pool is destroyed.
+  void run() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        available.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (stopping && tasks.empty()) {
+          return;
+        }
+
+        task = std::move(tasks.front());
+        tasks.pop();
+      }
+
+      try {
+        task();
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--pending == 0) {
+        finished.notify_all();
+      }
+    }
+  }
+};
+
+#endif